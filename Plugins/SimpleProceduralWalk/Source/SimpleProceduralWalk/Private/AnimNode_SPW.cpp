@@ -2,6 +2,7 @@
 
 #include "AnimNode_SPW.h"
 #include "SPW.h"
+#include "SPWWalkProfile.h"
 #include "Animation/AnimInstanceProxy.h"
 #include "GameFramework/Pawn.h"
 #include "GameFramework/Character.h"
@@ -13,11 +14,24 @@
 // log
 DEFINE_LOG_CATEGORY(LogSimpleProceduralWalk);
 
+// stats
+DEFINE_STAT(STAT_SPW_Computations);
+DEFINE_STAT(STAT_SPW_FeetTargets);
+DEFINE_STAT(STAT_SPW_BodySolver);
+DEFINE_STAT(STAT_SPW_CCDIKSolver);
+DEFINE_STAT(STAT_SPW_VirtualBones);
+DEFINE_STAT(STAT_SPW_CCDIKSolvedLegs);
+DEFINE_STAT(STAT_SPW_CCDIKCachedLegs);
+DEFINE_STAT(STAT_SPW_CCDIKIterations);
+DEFINE_STAT(STAT_SPW_GovernorLevel);
+DEFINE_STAT(STAT_SPW_GovernorFrameTime);
+
 
 FAnimNode_SPW::FAnimNode_SPW() : Super()
 , bDebug(false)
 , bScaleWithSkeletalMesh(true)
 , bDetectFalling(true)
+, WalkProfile()
 , SkeletalMeshForwardAxis(ESimpleProceduralWalk_MeshForwardAxis::Y)
 , BodyBone()
 , Legs()
@@ -43,78 +57,137 @@ FAnimNode_SPW::FAnimNode_SPW() : Super()
 , BodyRotationInterpSpeed(2.5f)
 , BodyAccelerationRotationMultiplier(.1f)
 , BodyFeetLocationsRotationMultiplier(.75f)
+, bBodyRotateOnFeetPlane(false)
 , MaxBodyRotation(FRotator(45.f, 0.f, 45.f))
 , SolverType(ESimpleProceduralWalk_SolverType::ADVANCED)
 , FeetInAirInterSpeed(15.f)
 , RadiusCheckMultiplier(1.5f)
 , DistanceCheckMultiplier(1.2f)
+, MaxSubstepDeltaTime(1.f / 30.f)
+, MaxSubsteps(4)
 , bEnableIkSolver(true)
 , bStartFromTail(false)
 , Precision(1.f)
 , MaxIterations(10)
+, bVectorizedSolver(true)
+, bCacheSolvedLegs(true)
+, CacheTolerance(.01f)
+, bAdaptiveIterations(false)
+, AdaptiveNearDistance(500.f)
+, AdaptiveFarDistance(3000.f)
+, FarPrecision(5.f)
+, FarMaxIterations(2)
+, TimeBudgetMicroseconds(0.f)
 , TraceChannel()
 , TraceLength(350.f)
 , bTraceComplex(true)
 , TraceZOffset(50.f)
+, bTickAfterSkinnedSupports(false)
+, bEnableQualityTiers(false)
+, Significance(-1.f)
+, ReducedSignificance(.1f)
+, BodyOnlySignificance(.03f)
+, FrozenSignificance(.01f)
+, SignificanceHysteresis(.2f)
+, ReducedTraceInterval(3)
+, TierBlendTime(.25f)
+, BakedGaitBlendSpace()
+, BakedGaitCycles(1)
+, bEnableOffScreenMode(false)
+, bRaiseStepEventsOffScreen(true)
+, bEnableSleep(false)
+, SleepDelay(1.f)
+, bKeepAwake(false)
+, bEnablePoseSharing(false)
+, PoseSharingSignificance(.05f)
+, MaxClonesPerTemplate(25)
+, PoseSharingMaxDistance(3000.f)
 {
-	CreateDefaultCurves();
 }
 
-void FAnimNode_SPW::CreateDefaultCurves()
+void FAnimNode_SPW::ApplyWalkProfile()
 {
-	/** ROBOT */
-	// -----\/----- height curve
-	FRichCurveKey RHKey0 = FRichCurveKey(0.f, 0.f, 2.8878f, 2.8878f, ERichCurveInterpMode::RCIM_Cubic);
-	FRichCurveKey RHKey1 = FRichCurveKey(0.5f, 1.f, 2.8878f, 2.8878f, ERichCurveInterpMode::RCIM_Cubic);
-	FRichCurveKey RHKey2 = FRichCurveKey(1.f, 0.f, 2.8878f, 2.8878f, ERichCurveInterpMode::RCIM_Cubic);
-
-	RHKey0.TangentMode = ERichCurveTangentMode::RCTM_Break;
-	RHKey1.TangentMode = ERichCurveTangentMode::RCTM_Auto;
-	RHKey2.TangentMode = ERichCurveTangentMode::RCTM_Break;
-
-	TArray<FRichCurveKey> RHCurveKeys;
-	RHCurveKeys.Add(RHKey0);
-	RHCurveKeys.Add(RHKey1);
-	RHCurveKeys.Add(RHKey2);
-	StepHeightCurveRobot.SetKeys(RHCurveKeys);
-
-	/** ORGANIC */
-	// -----\/----- height curveasdasd
-	FRichCurveKey OHKey0 = FRichCurveKey(0.f, 0.f, 2.8878f, 2.8878f, ERichCurveInterpMode::RCIM_Cubic);
-	FRichCurveKey OHKey1 = FRichCurveKey(0.2f, 1.f, 0.f, 0.f, ERichCurveInterpMode::RCIM_Cubic);
-	FRichCurveKey OHKey2 = FRichCurveKey(1.f, 0.f, -2.8878f, -2.8878f, ERichCurveInterpMode::RCIM_Cubic);
-
-	OHKey0.TangentMode = ERichCurveTangentMode::RCTM_Auto;
-	OHKey1.TangentMode = ERichCurveTangentMode::RCTM_Auto;
-	OHKey2.TangentMode = ERichCurveTangentMode::RCTM_Auto;
-
-	TArray<FRichCurveKey> OHCurveKeys;
-	OHCurveKeys.Add(OHKey0);
-	OHCurveKeys.Add(OHKey1);
-	OHCurveKeys.Add(OHKey2);
-	StepHeightCurveOrganic.SetKeys(OHCurveKeys);
-
-	/** COMMON */
-	// -----\/----- distsadance curve
-	FRichCurveKey DKey0 = FRichCurveKey(0.f, 0.f, 0.f, 0.f, ERichCurveInterpMode::RCIM_Cubic);
-	FRichCurveKey DKey1 = FRichCurveKey(1.f, 1.f, 0.f, 0.f, ERichCurveInterpMode::RCIM_Cubic);
-
-	DKey0.TangentMode = ERichCurveTangentMode::RCTM_Auto;
-	DKey1.TangentMode = ERichCurveTangentMode::RCTM_Auto;
-
-	TArray<FRichCurveKey> DCurveKeys;
-	DCurveKeys.Add(DKey0);
-	DCurveKeys.Add(DKey1);
-
-	StepDistanceCurveRobot.SetKeys(DCurveKeys);
-	StepDistanceCurveOrganic.SetKeys(DCurveKeys);
+	if (!IsValid(WalkProfile))
+	{
+		if (StepCurveType == ESimpleProceduralWalk_StepCurveType::CUSTOM)
+		{
+			// bake custom curves, so that they are never accessed while evaluating
+			if (!CustomStepCurves.IsValid())
+			{
+				CustomStepCurves = MakeShared<FSimpleProceduralWalk_StepCurves>();
+			}
+			CustomStepCurves->Bake(CustomStepHeightCurve, CustomStepDistanceCurve);
+			StepCurves = CustomStepCurves.Get();
+		}
+		else
+		{
+			// built-in curves
+			CustomStepCurves.Reset();
+			StepCurves = &FSimpleProceduralWalk_StepCurves::GetDefault(StepCurveType);
+		}
+		return;
+	}
+
+	// settings are read from the profile (see the walk settings getters), only the node's own curves are released
+	CustomStepCurves.Reset();
+
+	// baked curves
+	StepCurves = &WalkProfile->GetStepCurves();
 }
 
+#if WITH_EDITOR
+void FAnimNode_SPW::UpdateStepCurves()
+{
+	if (IsValid(WalkProfile))
+	{
+		// the profile is shared by many nodes: rebake on the game thread
+		if (WalkProfile->AreStepCurvesStale())
+		{
+			TWeakObjectPtr<USPWWalkProfile> WeakWalkProfile = WalkProfile;
+			AsyncTask(ENamedThreads::GameThread, [WeakWalkProfile]() {
+				if (WeakWalkProfile.IsValid())
+				{
+					WeakWalkProfile->RebakeStaleStepCurves();
+				}
+			});
+		}
+	}
+	else if (CustomStepCurves.IsValid() && CustomStepCurves->IsStale(CustomStepHeightCurve, CustomStepDistanceCurve))
+	{
+		CustomStepCurves->Bake(CustomStepHeightCurve, CustomStepDistanceCurve);
+	}
+}
+#endif
+
 void FAnimNode_SPW::GatherDebugData(FNodeDebugData& DebugData)
 {
 	FString DebugLine = DebugData.GetNodeName(this);
+	DebugLine += FString::Printf(TEXT("(IK cache hits: %u / %u, quality tier: %s, significance: %.3f%s%s)")
+		, CCDIKCacheHits
+		, CCDIKCacheHits + CCDIKCacheMisses
+		, *UEnum::GetValueAsString(CurrentQualityTier)
+		, CurrentSignificance
+		, bIsAsleep ? TEXT(", asleep") : TEXT("")
+		, bIsPoseClone ? TEXT(", pose clone") : TEXT(""));
 
 	DebugData.AddDebugItem(DebugLine);
+
+	// IK quality per leg
+	for (int LegIndex = 0; LegIndex < CCDIKLegChains.Num(); LegIndex++)
+	{
+		const FSPW_CCDIKLegChain& LegChain = CCDIKLegChains[LegIndex];
+		if (LegChain.bIsGathered)
+		{
+			DebugData.AddDebugItem(FString::Printf(TEXT("Leg %d: %d / %d iterations, residual error %.2f (precision %.2f)%s")
+				, LegIndex
+				, LegChain.Iterations
+				, LegChain.MaxIterations
+				, LegChain.ResidualError
+				, LegChain.Precision
+				, LegChain.bIsCacheHit ? TEXT(", cached") : TEXT("")));
+		}
+	}
+
 	ComponentPose.GatherDebugData(DebugData);
 }
 
@@ -128,35 +201,48 @@ void FAnimNode_SPW::InitializeBoneReferences(const FBoneContainer& RequiredBones
 	BodyBone.Initialize(RequiredBones);
 	UE_LOG(LogSimpleProceduralWalk, VeryVerbose, TEXT("Body bone %s initialized."), *BodyBone.BoneName.ToString());
 
+	// validate bones again
+	bIsBoneValidationCached = false;
+
+	// invalidate IK cache
+	for (FSPW_CCDIKLegChain& LegChain : CCDIKLegChains)
+	{
+		LegChain.bIsCacheValid = false;
+	}
+
 	// bones
 	ParentBones.Reset();
 	TipBones.Reset();
 	EffectorTargets.Reset();
+	LegsChainValid.Reset();
+	FeetRotationLimitsPerJoints.SetNum(Legs.Num());
+
+	const FReferenceSkeleton& RefSkeleton = RequiredBones.GetReferenceSkeleton();
 
-	for (FSimpleProceduralWalk_Leg Leg : Legs)
+	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
 	{
+		FSimpleProceduralWalk_Leg& Leg = Legs[LegIndex];
+		FBoneReference ParentParentBone;
+		FBoneReference TipBone;
+		bool bIsChainValid = false;
+
 		if (Leg.ParentBone.Initialize(RequiredBones))
 		{
 			// CCDIK exclude the parent bone from the solver, so in order to keep a simple UX in selecting the bones,
 			// we have to add the parent's parent here.
 			// NB: the fact that the parent bone is NOT root is ensured by the validation in the AnimGraphNode.
-			const FCompactPoseBoneIndex ParentParentIndex = RequiredBones.GetParentBoneIndex(Leg.ParentBone.GetCompactPoseIndex(RequiredBones));
-			FBoneReference ParentParentBone = RequiredBones.GetReferenceSkeleton().GetBoneName(ParentParentIndex.GetInt());
+			// Bones removed by the current LOD are replaced by their closest ancestor.
+			const int32 ParentParentIndex = GetLODBoneIndex(RequiredBones, RefSkeleton.GetParentIndex(Leg.ParentBone.BoneIndex));
+			ParentParentBone = FBoneReference(ParentParentIndex != INDEX_NONE ? RefSkeleton.GetBoneName(ParentParentIndex) : NAME_None);
 
 			if (ParentParentBone.Initialize(RequiredBones))
 			{
-				ParentBones.Emplace(ParentParentBone);
 				UE_LOG(LogSimpleProceduralWalk, VeryVerbose, TEXT("%s bone's parent initialized."), *Leg.ParentBone.BoneName.ToString());
 			}
 			else
 			{
 				UE_LOG(LogSimpleProceduralWalk, Error, TEXT("Could not initialize %s bone's parent."), *Leg.ParentBone.BoneName.ToString());
 			}
-
-			// init effector target
-			FBoneSocketTarget EffectorTarget = FBoneSocketTarget(ParentParentBone.BoneName);
-			EffectorTarget.InitializeBoneReferences(RequiredBones);
-			EffectorTargets.Emplace(EffectorTarget);
 		}
 		else
 		{
@@ -165,19 +251,74 @@ void FAnimNode_SPW::InitializeBoneReferences(const FBoneContainer& RequiredBones
 
 		if (Leg.TipBone.Initialize(RequiredBones))
 		{
-			TipBones.Emplace(Leg.TipBone);
+			// tip bone, or its closest ancestor kept by the current LOD
+			const int32 TipIndex = GetLODBoneIndex(RequiredBones, Leg.TipBone.BoneIndex);
+			TipBone = FBoneReference(TipIndex != INDEX_NONE ? RefSkeleton.GetBoneName(TipIndex) : NAME_None);
+			TipBone.Initialize(RequiredBones);
+
+			// a chain needs at least one bone between the parent bone and the tip
+			bIsChainValid = TipIndex != INDEX_NONE
+				&& Leg.ParentBone.BoneIndex != INDEX_NONE
+				&& TipIndex != GetLODBoneIndex(RequiredBones, Leg.ParentBone.BoneIndex);
+
+			if (TipBone.BoneName != Leg.TipBone.BoneName)
+			{
+				UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("%s bone is removed by LOD, using %s instead."), *Leg.TipBone.BoneName.ToString(), *TipBone.BoneName.ToString());
+			}
 			UE_LOG(LogSimpleProceduralWalk, VeryVerbose, TEXT("%s bone initialized."), *Leg.TipBone.BoneName.ToString());
 		}
 		else
 		{
 			UE_LOG(LogSimpleProceduralWalk, Error, TEXT("Could not initialize bone %s."), *Leg.TipBone.BoneName.ToString());
 		}
+
+		// save
+		ParentBones.Emplace(ParentParentBone);
+		TipBones.Emplace(TipBone);
+		LegsChainValid.Add(bIsChainValid);
+
+		// init effector target
+		FBoneSocketTarget EffectorTarget = FBoneSocketTarget(ParentParentBone.BoneName);
+		EffectorTarget.InitializeBoneReferences(RequiredBones);
+		EffectorTargets.Emplace(EffectorTarget);
+
+		// rotation limits of the bones kept by the current LOD
+		CCDIK_RemapRotationLimits(LegIndex, RequiredBones);
 	}
 }
 
-bool FAnimNode_SPW::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones)
+int32 FAnimNode_SPW::GetLODBoneIndex(const FBoneContainer& RequiredBones, int32 MeshBoneIndex) const
 {
-	UE_LOG(LogSimpleProceduralWalk, VeryVerbose, TEXT("IsValidToEvaluate"));
+	const FReferenceSkeleton& RefSkeleton = RequiredBones.GetReferenceSkeleton();
+
+	while (MeshBoneIndex != INDEX_NONE && !RequiredBones.Contains(static_cast<FBoneIndexType>(MeshBoneIndex)))
+	{
+		MeshBoneIndex = RefSkeleton.GetParentIndex(MeshBoneIndex);
+	}
+
+	return MeshBoneIndex;
+}
+
+bool FAnimNode_SPW::AreBonesValidToEvaluate(const FBoneContainer& RequiredBones)
+{
+	UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Validating bones for bone container %d."), RequiredBones.GetSerialNumber());
+
+	// virtual bones, by compact pose index
+	const FReferenceSkeleton& RefSkeleton = RequiredBones.GetReferenceSkeleton();
+	VirtualBonesMask.Init(false, RequiredBones.GetCompactPoseNumBones());
+
+	for (const FName& VirtualBoneName : VirtualBoneNames)
+	{
+		const int32 MeshBoneIndex = RefSkeleton.FindBoneIndex(VirtualBoneName);
+		if (MeshBoneIndex != INDEX_NONE)
+		{
+			const FCompactPoseBoneIndex CompactPoseIndex = RequiredBones.MakeCompactPoseIndex(FMeshPoseBoneIndex(MeshBoneIndex));
+			if (CompactPoseIndex != INDEX_NONE)
+			{
+				VirtualBonesMask[CompactPoseIndex.GetInt()] = true;
+			}
+		}
+	}
 
 	if (BodyBone.BoneIndex != INDEX_NONE)
 	{
@@ -190,6 +331,12 @@ bool FAnimNode_SPW::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneCont
 
 	for (int BoneIndex = 0; BoneIndex < ParentBones.Num(); BoneIndex++)
 	{
+		if (BoneIndex < LegsChainValid.Num() && !LegsChainValid[BoneIndex])
+		{
+			// leg is skipped at this LOD
+			continue;
+		}
+
 		if (BoneIndex < ParentBones.Num())
 		{
 			if (!ParentBones[BoneIndex].IsValidToEvaluate(RequiredBones))
@@ -207,7 +354,7 @@ bool FAnimNode_SPW::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneCont
 				return false;
 			}
 
-			if (VirtualBoneNames.Find(TipBones[BoneIndex].BoneName) == INDEX_NONE)
+			if (!VirtualBonesMask[TipBones[BoneIndex].GetCompactPoseIndex(RequiredBones).GetInt()])
 			{
 				/* --> not a virtual bone */
 
@@ -222,7 +369,27 @@ bool FAnimNode_SPW::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneCont
 		}
 	}
 
-	if (!IsValid(SkeletalMeshComponent))
+	return true;
+}
+
+bool FAnimNode_SPW::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones)
+{
+	UE_LOG(LogSimpleProceduralWalk, VeryVerbose, TEXT("IsValidToEvaluate"));
+
+	// bones are validated once per bone container
+	if (!bIsBoneValidationCached || ValidatedBoneContainerSerial != RequiredBones.GetSerialNumber())
+	{
+		bAreBonesValidToEvaluate = AreBonesValidToEvaluate(RequiredBones);
+		ValidatedBoneContainerSerial = RequiredBones.GetSerialNumber();
+		bIsBoneValidationCached = true;
+	}
+
+	if (!bAreBonesValidToEvaluate)
+	{
+		return false;
+	}
+
+	if (!SkeletalMeshComponent.IsValid())
 	{
 		UE_LOG(LogSimpleProceduralWalk, Warning, TEXT("IsValidToEvaluate: SkeletalMeshComponent is not valid."));
 		return false;
@@ -234,7 +401,7 @@ bool FAnimNode_SPW::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneCont
 		return false;
 	}
 
-	if (Precision <= 0)
+	if (GetPrecision() <= 0)
 	{
 		UE_LOG(LogSimpleProceduralWalk, Warning, TEXT("IsValidToEvaluate: Precision is not valid."));
 		return false;
@@ -260,6 +427,7 @@ void FAnimNode_SPW::Initialize_AnyThread(const FAnimationInitializeContext& Cont
 	WorldContext = SkeletalMeshComponent->GetWorld();
 
 	// virtual bones array
+	bIsBoneValidationCached = false;
 	VirtualBoneNames.Reset();
 	for (FVirtualBone VirtualBone : SkeletalMeshComponent->SkeletalMesh->Skeleton->GetVirtualBones())
 	{
@@ -275,6 +443,9 @@ void FAnimNode_SPW::Initialize_AnyThread(const FAnimationInitializeContext& Cont
 
 	UE_LOG(LogSimpleProceduralWalk, VeryVerbose, TEXT("Is playing: %d, is in editor: %d"), bIsPlaying, bIsEditorAnimPreview);
 
+	// shared settings
+	ApplyWalkProfile();
+
 	if (bIsPlaying)
 	{
 		// get pawn & character
@@ -284,7 +455,7 @@ void FAnimNode_SPW::Initialize_AnyThread(const FAnimationInitializeContext& Cont
 		bIsPawnClass = !IsValid(Cast<ACharacter>(SkeletalMeshOwner));
 		UE_LOG(LogSimpleProceduralWalk, VeryVerbose, TEXT("bIsPawnClass: %d"), bIsPawnClass);
 
-		if (!IsValid(OwnerPawn))
+		if (!OwnerPawn.IsValid())
 		{
 			bHasErrors = true;
 			UE_LOG(LogSimpleProceduralWalk, Error, TEXT("Owner actor %s must be a Pawn / Character."), *UKismetSystemLibrary::GetDisplayName(SkeletalMeshOwner));
@@ -331,21 +502,82 @@ void FAnimNode_SPW::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext
 	SkeletalMeshComponent = Output.AnimInstanceProxy->GetSkelMeshComponent();
 	WorldContext = SkeletalMeshComponent->GetWorld();
 
-	if (bIsPlaying)
+	// baked gait, under the procedural pose
+	if (bIsPlaying && bIsBakedGaitPlaying)
+	{
+		Evaluate_BakedGait(Output);
+	}
+
+	// faded out (frozen), or owner destroyed
+	if (bIsPlaying && OwnerPawn.IsValid() && FAnimWeight::IsRelevant(QualityTierBlendWeight))
 	{
-		// body
-		Evaluate_BodySolver(Output);
+		const uint32 StartCycles = FPlatformTime::Cycles();
+
+		// sleeping walkers wake up when the incoming pose changes
+		if (bEnableSleep && bIsInitialized)
+		{
+			Evaluate_SleepInputPose(Output);
+		}
 
-		if (bEnableIkSolver)
+		if (bIsPoseClone && bEnableIkSolver && ApplyTemplateBones(Output))
 		{
-			// IK
-			Evaluate_CCDIKSolver(Output);
+			// body & legs already solved by the template walker
 		}
 		else
 		{
-			// virtual bones
-			Evaluate_TransformBones(Output, OutBoneTransforms);
+			// body
+			Evaluate_BodySolver(Output);
+
+			if (bEnableIkSolver)
+			{
+				// IK (not solved while the mesh is not rendered)
+				if (!bIsOffScreen)
+				{
+					Evaluate_CCDIKSolver(Output);
+
+					// shared with clones
+					if (bEnablePoseSharing && bIsPoseTemplate)
+					{
+						RecordSolvedBones(Output);
+					}
+				}
+			}
+			else
+			{
+				// virtual bones
+				Evaluate_TransformBones(Output, OutBoneTransforms);
+			}
 		}
+
+		// governor
+		FSimpleProceduralWalk_Governor::Get().AddCycles(FPlatformTime::Cycles() - StartCycles);
+	}
+}
+
+void FAnimNode_SPW::PreUpdate(const UAnimInstance* InAnimInstance)
+{
+	// game thread, before the update
+	// step events queued by the previous update
+	FlushStepEvents();
+
+	// skinned mesh supports: copy the bones now, their component space transforms are not read on the worker
+	for (FSimpleProceduralWalk_LegSupport& Support : LegsData.Supports)
+	{
+		Support.UpdateBoneTransform();
+	}
+
+	// actors ignored by the traces
+	TraceQueryParams.ClearIgnoredActors();
+	if (APawn* Pawn = OwnerPawn.Get())
+	{
+		TraceQueryParams.AddIgnoredActor(Pawn);
+	}
+
+	// cameras & visibility, for the off screen mode, quality tiers, pose sharing & adaptive IK
+	const USkeletalMeshComponent* InSkeletalMeshComponent = InAnimInstance->GetSkelMeshComponent();
+	if (InSkeletalMeshComponent != nullptr)
+	{
+		GatherViews(InSkeletalMeshComponent);
 	}
 }
 
@@ -361,8 +593,31 @@ void FAnimNode_SPW::UpdateInternal(const FAnimationUpdateContext& Context)
 	SkeletalMeshComponent = Context.AnimInstanceProxy->GetSkelMeshComponent();
 	WorldContext = SkeletalMeshComponent->GetWorld();
 
-	if (bIsPlaying)
+#if WITH_EDITOR
+	// curve assets edited while playing
+	UpdateStepCurves();
+#endif
+
+	// (owner destroyed)
+	if (bIsPlaying && OwnerPawn.IsValid())
 	{
+		const uint32 StartCycles = FPlatformTime::Cycles();
+
+		// scalability, governor, off screen & quality tier
+		UpdateScalability();
+		UpdateGovernor();
+		UpdateOffScreen();
+
+		// view (shared by the quality tiers, pose sharing & adaptive IK)
+		if (bEnableQualityTiers || bEnablePoseSharing || (bEnableIkSolver && bAdaptiveIterations))
+		{
+			UpdateView();
+		}
+
+		UpdateQualityTier();
+		UpdateBakedGait();
+		UpdatePoseSharing();
+
 		// falling events
 		if (bIsInitialized)
 		{
@@ -371,9 +626,17 @@ void FAnimNode_SPW::UpdateInternal(const FAnimationUpdateContext& Context)
 				// reset feet targets & locations
 				ResetFeetTargetsAndLocations();
 				bForceReset = false;
+
+				if (bIsAsleep)
+				{
+					WakeUp();
+				}
 			}
 
-			if (bDetectFalling)
+			if (bDetectFalling
+				&& !bIsOffScreen
+				&& !bIsAsleep
+				&& (CurrentQualityTier == ESimpleProceduralWalk_QualityTier::FULL || CurrentQualityTier == ESimpleProceduralWalk_QualityTier::REDUCED))
 			{
 				if (IsFalling())
 				{
@@ -408,6 +671,9 @@ void FAnimNode_SPW::UpdateInternal(const FAnimationUpdateContext& Context)
 
 		// compute procedurals
 		Evaluate_Computations();
+
+		// governor
+		FSimpleProceduralWalk_Governor::Get().AddCycles(FPlatformTime::Cycles() - StartCycles);
 	}
 	else if (bIsEditorAnimPreview)
 	{
@@ -421,7 +687,7 @@ void FAnimNode_SPW::CallLandedInterfaces()
 	// pawn
 	if (OwnerPawn->GetClass()->ImplementsInterface(USimpleProceduralWalkInterface::StaticClass()))
 	{
-		CallLandedInterface(OwnerPawn);
+		CallLandedInterface(OwnerPawn.Get());
 	}
 	// anim instance
 	if (SkeletalMeshComponent->GetAnimInstance()->GetClass()->ImplementsInterface(USimpleProceduralWalkInterface::StaticClass()))
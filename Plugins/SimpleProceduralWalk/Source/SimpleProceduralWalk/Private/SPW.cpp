@@ -0,0 +1,574 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#include "SPW.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "GameFramework/Actor.h"
+#include "Curves/CurveFloat.h"
+#include "HAL/IConsoleManager.h"
+
+
+// ---------- \/ leg support ----------
+void FSimpleProceduralWalk_LegSupport::SetComponent(UPrimitiveComponent* InComponent, FName InBoneName)
+{
+	Component = InComponent;
+	BoneName = InBoneName;
+	bIsStatic = false;
+
+	// skinned mesh bone, no name lookup afterwards
+	const USkinnedMeshComponent* SkinnedComp = Cast<USkinnedMeshComponent>(InComponent);
+	BoneIndex = SkinnedComp != nullptr && InBoneName != NAME_None ? SkinnedComp->GetBoneIndex(InBoneName) : INDEX_NONE;
+	bHasBoneTransform = false;
+}
+
+void FSimpleProceduralWalk_LegSupport::UpdateBoneTransform()
+{
+	const USkinnedMeshComponent* SkinnedComp = Cast<USkinnedMeshComponent>(Component.Get());
+	if (BoneIndex == INDEX_NONE || SkinnedComp == nullptr)
+	{
+		return;
+	}
+
+	// (the mesh may have changed since the foot was planted)
+	// on the game thread, the component space transforms are the last completed evaluation
+	const FTransform NewBoneTransform = BoneIndex < SkinnedComp->GetNumComponentSpaceTransforms() && SkinnedComp->GetBoneName(BoneIndex) == BoneName
+		? SkinnedComp->GetBoneTransform(BoneIndex)
+		: SkinnedComp->GetSocketTransform(BoneName);
+
+	if (!bHasBoneTransform)
+	{
+		// first copy since the foot was planted
+		PreviousTransform = NewBoneTransform;
+		RelLocation = NewBoneTransform.InverseTransformPosition(PlantLocation);
+		bHasBoneTransform = true;
+	}
+
+	BoneTransform = NewBoneTransform;
+}
+
+FTransform FSimpleProceduralWalk_LegSupport::GetTransform(const UPrimitiveComponent* SupportComp) const
+{
+	if (BoneIndex != INDEX_NONE)
+	{
+		return BoneTransform;
+	}
+
+	return SupportComp->GetSocketTransform(BoneName);
+}
+
+// ---------- \/ leg hit ----------
+void FSimpleProceduralWalk_LegHit::SetFromHitResult(const FHitResult& Hit)
+{
+	ImpactPoint = Hit.ImpactPoint;
+	ImpactNormal = Hit.ImpactNormal;
+	Component = Hit.Component;
+	BoneName = Hit.BoneName;
+	PhysMaterial = Hit.PhysMaterial;
+	bBlockingHit = Hit.bBlockingHit;
+}
+
+FHitResult FSimpleProceduralWalk_LegHit::ToHitResult() const
+{
+	FHitResult Hit(ForceInit);
+
+	Hit.bBlockingHit = bBlockingHit;
+	Hit.Location = ImpactPoint;
+	Hit.ImpactPoint = ImpactPoint;
+	Hit.Normal = ImpactNormal;
+	Hit.ImpactNormal = ImpactNormal;
+	Hit.Component = Component;
+	Hit.Actor = Component.IsValid() ? Component->GetOwner() : nullptr;
+	Hit.BoneName = BoneName;
+	Hit.PhysMaterial = PhysMaterial;
+
+	return Hit;
+}
+
+// ---------- \/ legs data ----------
+void FSimpleProceduralWalk_LegsData::SetNum(int32 NumLegs)
+{
+	FootLocations.Init(FVector(0.f), NumLegs);
+	FootTargets.Init(FVector(0.f), NumLegs);
+	FootUnplantLocations.Init(FVector(0.f), NumLegs);
+	FootTargetRotations.Init(FQuat::Identity, NumLegs);
+	SupportCompDeltas.Init(FVector(0.f), NumLegs);
+	GroupIndices.Init(0, NumLegs);
+	Flags.Init(ESimpleProceduralWalk_LegFlags::None, NumLegs);
+
+	TipBoneOriginalRelLocations.Init(FVector(0.f), NumLegs);
+	Lengths.Init(0.f, NumLegs);
+
+	LastHits.Reset();
+	LastHits.SetNum(NumLegs);
+	Supports.Reset();
+	Supports.SetNum(NumLegs);
+}
+
+// ---------- \/ baked curve ----------
+void FSimpleProceduralWalk_BakedCurve::Bake(const FRichCurve& Curve)
+{
+	for (int32 SampleIndex = 0; SampleIndex < SPW_BAKED_CURVE_SAMPLES; SampleIndex++)
+	{
+		Samples[SampleIndex] = Curve.Eval(static_cast<float>(SampleIndex) / (SPW_BAKED_CURVE_SAMPLES - 1));
+	}
+}
+
+float FSimpleProceduralWalk_BakedCurve::GetMaxDeviation(const FRichCurve& Curve) const
+{
+	// check 8 points per segment
+	static const int32 NumChecks = (SPW_BAKED_CURVE_SAMPLES - 1) * 8;
+
+	float MaxDeviation = 0.f;
+	for (int32 CheckIndex = 0; CheckIndex <= NumChecks; CheckIndex++)
+	{
+		const float Time = static_cast<float>(CheckIndex) / NumChecks;
+		MaxDeviation = FMath::Max(MaxDeviation, FMath::Abs(Eval(Time) - Curve.Eval(Time)));
+	}
+
+	return MaxDeviation;
+}
+
+// ---------- \/ step curves ----------
+#if WITH_EDITOR
+/* -> hash of the curve assets & of their keys */
+static uint32 GetStepCurvesSourceHash(const UCurveFloat* InHeightCurve, const UCurveFloat* InDistanceCurve)
+{
+	uint32 Hash = 0;
+	for (const UCurveFloat* Curve : { InHeightCurve, InDistanceCurve })
+	{
+		Hash = HashCombine(Hash, GetTypeHash(Curve));
+		if (Curve != nullptr)
+		{
+			for (const FRichCurveKey& Key : Curve->FloatCurve.Keys)
+			{
+				Hash = HashCombine(Hash, HashCombine(GetTypeHash(Key.Time), GetTypeHash(Key.Value)));
+				Hash = HashCombine(Hash, HashCombine(GetTypeHash(Key.ArriveTangent), GetTypeHash(Key.LeaveTangent)));
+				Hash = HashCombine(Hash, GetTypeHash((uint8)Key.InterpMode));
+			}
+		}
+	}
+	return Hash;
+}
+
+bool FSimpleProceduralWalk_StepCurves::IsStale(const UCurveFloat* InHeightCurve, const UCurveFloat* InDistanceCurve) const
+{
+	return SourceHash != GetStepCurvesSourceHash(InHeightCurve, InDistanceCurve);
+}
+#endif
+
+void FSimpleProceduralWalk_StepCurves::Bake(const UCurveFloat* InHeightCurve, const UCurveFloat* InDistanceCurve)
+{
+	HeightCurve.Bake(InHeightCurve != nullptr ? InHeightCurve->FloatCurve : FRichCurve());
+	DistanceCurve.Bake(InDistanceCurve != nullptr ? InDistanceCurve->FloatCurve : FRichCurve());
+#if WITH_EDITOR
+	SourceHash = GetStepCurvesSourceHash(InHeightCurve, InDistanceCurve);
+#endif
+
+	UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Baked custom step curves, max deviation: height %f, distance %f.")
+		, InHeightCurve != nullptr ? HeightCurve.GetMaxDeviation(InHeightCurve->FloatCurve) : 0.f
+		, InDistanceCurve != nullptr ? DistanceCurve.GetMaxDeviation(InDistanceCurve->FloatCurve) : 0.f);
+}
+
+namespace SimpleProceduralWalk_StepCurves
+{
+	FRichCurve CreateDistanceCurve()
+	{
+		FRichCurve Curve;
+
+		// -----\/----- distance curve (common)
+		FRichCurveKey DKey0 = FRichCurveKey(0.f, 0.f, 0.f, 0.f, ERichCurveInterpMode::RCIM_Cubic);
+		FRichCurveKey DKey1 = FRichCurveKey(1.f, 1.f, 0.f, 0.f, ERichCurveInterpMode::RCIM_Cubic);
+
+		DKey0.TangentMode = ERichCurveTangentMode::RCTM_Auto;
+		DKey1.TangentMode = ERichCurveTangentMode::RCTM_Auto;
+
+		Curve.SetKeys({ DKey0, DKey1 });
+
+		return Curve;
+	}
+
+	FRichCurve CreateHeightCurve(ESimpleProceduralWalk_StepCurveType StepCurveType)
+	{
+		FRichCurve Curve;
+
+		switch (StepCurveType)
+		{
+		case ESimpleProceduralWalk_StepCurveType::ROBOT:
+		{
+			// -----\/----- height curve (robot)
+			FRichCurveKey HKey0 = FRichCurveKey(0.f, 0.f, 2.8878f, 2.8878f, ERichCurveInterpMode::RCIM_Cubic);
+			FRichCurveKey HKey1 = FRichCurveKey(0.5f, 1.f, 2.8878f, 2.8878f, ERichCurveInterpMode::RCIM_Cubic);
+			FRichCurveKey HKey2 = FRichCurveKey(1.f, 0.f, 2.8878f, 2.8878f, ERichCurveInterpMode::RCIM_Cubic);
+
+			HKey0.TangentMode = ERichCurveTangentMode::RCTM_Break;
+			HKey1.TangentMode = ERichCurveTangentMode::RCTM_Auto;
+			HKey2.TangentMode = ERichCurveTangentMode::RCTM_Break;
+
+			Curve.SetKeys({ HKey0, HKey1, HKey2 });
+			break;
+		}
+		case ESimpleProceduralWalk_StepCurveType::ORGANIC:
+		{
+			// -----\/----- height curve (organic)
+			FRichCurveKey HKey0 = FRichCurveKey(0.f, 0.f, 2.8878f, 2.8878f, ERichCurveInterpMode::RCIM_Cubic);
+			FRichCurveKey HKey1 = FRichCurveKey(0.2f, 1.f, 0.f, 0.f, ERichCurveInterpMode::RCIM_Cubic);
+			FRichCurveKey HKey2 = FRichCurveKey(1.f, 0.f, -2.8878f, -2.8878f, ERichCurveInterpMode::RCIM_Cubic);
+
+			HKey0.TangentMode = ERichCurveTangentMode::RCTM_Auto;
+			HKey1.TangentMode = ERichCurveTangentMode::RCTM_Auto;
+			HKey2.TangentMode = ERichCurveTangentMode::RCTM_Auto;
+
+			Curve.SetKeys({ HKey0, HKey1, HKey2 });
+			break;
+		}
+		default:
+			break;
+		}
+
+		return Curve;
+	}
+
+	static FSimpleProceduralWalk_StepCurves CreateBuiltIn(ESimpleProceduralWalk_StepCurveType StepCurveType)
+	{
+		FSimpleProceduralWalk_StepCurves Curves;
+		Curves.HeightCurve.Bake(CreateHeightCurve(StepCurveType));
+		Curves.DistanceCurve.Bake(CreateDistanceCurve());
+		return Curves;
+	}
+}
+
+const FSimpleProceduralWalk_StepCurves& FSimpleProceduralWalk_StepCurves::GetDefault(ESimpleProceduralWalk_StepCurveType StepCurveType)
+{
+	static const FSimpleProceduralWalk_StepCurves Robot = SimpleProceduralWalk_StepCurves::CreateBuiltIn(ESimpleProceduralWalk_StepCurveType::ROBOT);
+	static const FSimpleProceduralWalk_StepCurves Organic = SimpleProceduralWalk_StepCurves::CreateBuiltIn(ESimpleProceduralWalk_StepCurveType::ORGANIC);
+	static const FSimpleProceduralWalk_StepCurves Empty;
+
+	switch (StepCurveType)
+	{
+	case ESimpleProceduralWalk_StepCurveType::ROBOT:
+		return Robot;
+	case ESimpleProceduralWalk_StepCurveType::ORGANIC:
+		return Organic;
+	default:
+		return Empty;
+	}
+}
+
+// ---------- \/ space conversion ----------
+void SimpleProceduralWalk_SpaceConversion::TransformLocations(const FTransform& Transform, const FVector* InLocations, FVector* OutLocations, int32 Num)
+{
+	const FQuat Rotation = Transform.GetRotation();
+	const FVector Translation = Transform.GetTranslation();
+	const FVector Scale = Transform.GetScale3D();
+
+	const VectorRegister RotationReg = VectorLoadAligned(&Rotation);
+	const VectorRegister TranslationReg = VectorLoadFloat3_W0(&Translation);
+	const VectorRegister ScaleReg = VectorLoadFloat3_W0(&Scale);
+
+	for (int32 Index = 0; Index < Num; Index++)
+	{
+		// scale, rotate, translate
+		const VectorRegister LocationReg = VectorLoadFloat3_W0(&InLocations[Index]);
+		const VectorRegister ScaledReg = VectorMultiply(LocationReg, ScaleReg);
+		const VectorRegister RotatedReg = VectorQuaternionRotateVector(RotationReg, ScaledReg);
+		VectorStoreFloat3(VectorAdd(RotatedReg, TranslationReg), &OutLocations[Index]);
+	}
+}
+
+void SimpleProceduralWalk_SpaceConversion::InverseTransformLocations(const FTransform& Transform, const FVector* InLocations, FVector* OutLocations, int32 Num)
+{
+	const FQuat Rotation = Transform.GetRotation();
+	const FVector Translation = Transform.GetTranslation();
+	const FVector InvScale = FTransform::GetSafeScaleReciprocal(Transform.GetScale3D());
+
+	const VectorRegister RotationReg = VectorLoadAligned(&Rotation);
+	const VectorRegister TranslationReg = VectorLoadFloat3_W0(&Translation);
+	const VectorRegister InvScaleReg = VectorLoadFloat3_W0(&InvScale);
+
+	for (int32 Index = 0; Index < Num; Index++)
+	{
+		// untranslate, unrotate, unscale
+		const VectorRegister LocationReg = VectorLoadFloat3_W0(&InLocations[Index]);
+		const VectorRegister TranslatedReg = VectorSubtract(LocationReg, TranslationReg);
+		const VectorRegister UnrotatedReg = VectorQuaternionInverseRotateVector(RotationReg, TranslatedReg);
+		VectorStoreFloat3(VectorMultiply(UnrotatedReg, InvScaleReg), &OutLocations[Index]);
+	}
+}
+
+// ---------- \/ plane fit ----------
+void SimpleProceduralWalk_PlaneFit::FitPlane(const FVector* Locations, int32 Num, float& OutSlopeX, float& OutSlopeY)
+{
+	OutSlopeX = 0.f;
+	OutSlopeY = 0.f;
+
+	if (Num < 2)
+	{
+		return;
+	}
+
+	// running sums: (x, y, z), x * (x, y, z), y * (x, y, z)
+	VectorRegister SumReg = VectorZero();
+	VectorRegister SumXReg = VectorZero();
+	VectorRegister SumYReg = VectorZero();
+
+	for (int32 Index = 0; Index < Num; Index++)
+	{
+		const VectorRegister LocationReg = VectorLoadFloat3_W0(&Locations[Index]);
+		SumReg = VectorAdd(SumReg, LocationReg);
+		SumXReg = VectorMultiplyAdd(LocationReg, VectorReplicate(LocationReg, 0), SumXReg);
+		SumYReg = VectorMultiplyAdd(LocationReg, VectorReplicate(LocationReg, 1), SumYReg);
+	}
+
+	FVector Sum;
+	FVector SumX;
+	FVector SumY;
+	VectorStoreFloat3(SumReg, &Sum);
+	VectorStoreFloat3(SumXReg, &SumX);
+	VectorStoreFloat3(SumYReg, &SumY);
+
+	// centered (co)variances
+	const FVector Mean = Sum / Num;
+	const float Sxx = SumX.X - Sum.X * Mean.X;
+	const float Sxy = SumX.Y - Sum.X * Mean.Y;
+	const float Sxz = SumX.Z - Sum.X * Mean.Z;
+	const float Syy = SumY.Y - Sum.Y * Mean.Y;
+	const float Syz = SumY.Z - Sum.Y * Mean.Z;
+
+	// regularization (relative to the spread of the locations)
+	const float Regularization = (Sxx + Syy) * 1.e-3f + KINDA_SMALL_NUMBER;
+	const float RegSxx = Sxx + Regularization;
+	const float RegSyy = Syy + Regularization;
+
+	// normal equations (2x2)
+	const float Determinant = RegSxx * RegSyy - Sxy * Sxy;
+	if (FMath::Abs(Determinant) <= SMALL_NUMBER)
+	{
+		return;
+	}
+
+	OutSlopeX = (Sxz * RegSyy - Syz * Sxy) / Determinant;
+	OutSlopeY = (Syz * RegSxx - Sxz * Sxy) / Determinant;
+}
+
+// ---------- \/ rotation limits ----------
+void SimpleProceduralWalk_RotationLimits::Remap(const TArray<float>& RotationLimitPerJoints, TArrayView<const bool> bIsJointRequired, TArray<float>& OutRotationLimits)
+{
+	// parent's parent
+	OutRotationLimits.Reset();
+	OutRotationLimits.Add(0.f);
+
+	// limits of removed joints, waiting for a remaining child
+	float PendingRotationLimit = 0.f;
+
+	for (int32 JointIndex = 0; JointIndex < bIsJointRequired.Num(); JointIndex++)
+	{
+		const float RotationLimit = RotationLimitPerJoints.IsValidIndex(JointIndex) ? FMath::DegreesToRadians(RotationLimitPerJoints[JointIndex]) : 0.f;
+
+		if (bIsJointRequired[JointIndex])
+		{
+			OutRotationLimits.Add(FMath::Min(RotationLimit + PendingRotationLimit, PI));
+			PendingRotationLimit = 0.f;
+		}
+		else
+		{
+			PendingRotationLimit += RotationLimit;
+		}
+	}
+
+	// no remaining child
+	if (PendingRotationLimit > 0.f && OutRotationLimits.Num() > 1)
+	{
+		OutRotationLimits.Last() = FMath::Min(OutRotationLimits.Last() + PendingRotationLimit, PI);
+	}
+}
+
+// ---------- \/ scalability ----------
+static TAutoConsoleVariable<float> CVarSPWMaxIterationsScale(
+	TEXT("SPW.MaxIterationsScale"),
+	1.f,
+	TEXT("Scale of the IK Max Iterations of all Simple Procedural Walk nodes."),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<float> CVarSPWPrecisionScale(
+	TEXT("SPW.PrecisionScale"),
+	1.f,
+	TEXT("Scale of the IK Precision (tolerance) of all Simple Procedural Walk nodes, higher values are cheaper."),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<int32> CVarSPWForceBasicSolver(
+	TEXT("SPW.ForceBasicSolver"),
+	0,
+	TEXT("Use the BASIC solver in all Simple Procedural Walk nodes."),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<int32> CVarSPWAllowTraceComplex(
+	TEXT("SPW.AllowTraceComplex"),
+	1,
+	TEXT("Allow complex traces in Simple Procedural Walk nodes (0 traces against simple collision only)."),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<float> CVarSPWRadiusCheckScale(
+	TEXT("SPW.RadiusCheckScale"),
+	1.f,
+	TEXT("Scale of the Radius Check Multiplier of all Simple Procedural Walk nodes."),
+	ECVF_Scalability);
+
+static TAutoConsoleVariable<float> CVarSPWTraceLengthScale(
+	TEXT("SPW.TraceLengthScale"),
+	1.f,
+	TEXT("Scale of the Trace Length of all Simple Procedural Walk nodes."),
+	ECVF_Scalability);
+
+float FSimpleProceduralWalk_Scalability::GetMaxIterationsScale()
+{
+	return FMath::Max(CVarSPWMaxIterationsScale.GetValueOnAnyThread(), 0.f);
+}
+
+float FSimpleProceduralWalk_Scalability::GetPrecisionScale()
+{
+	return FMath::Max(CVarSPWPrecisionScale.GetValueOnAnyThread(), KINDA_SMALL_NUMBER);
+}
+
+bool FSimpleProceduralWalk_Scalability::IsBasicSolverForced()
+{
+	return CVarSPWForceBasicSolver.GetValueOnAnyThread() != 0;
+}
+
+bool FSimpleProceduralWalk_Scalability::IsTraceComplexAllowed()
+{
+	return CVarSPWAllowTraceComplex.GetValueOnAnyThread() != 0;
+}
+
+float FSimpleProceduralWalk_Scalability::GetRadiusCheckScale()
+{
+	return FMath::Max(CVarSPWRadiusCheckScale.GetValueOnAnyThread(), 0.f);
+}
+
+float FSimpleProceduralWalk_Scalability::GetTraceLengthScale()
+{
+	return FMath::Max(CVarSPWTraceLengthScale.GetValueOnAnyThread(), 0.f);
+}
+
+// ---------- \/ governor ----------
+static TAutoConsoleVariable<int32> CVarSPWGovernorEnable(
+	TEXT("SPW.Governor.Enable"),
+	0,
+	TEXT("Adjust the quality of all Simple Procedural Walk nodes to hold SPW.Governor.TargetMs."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSPWGovernorTargetMs(
+	TEXT("SPW.Governor.TargetMs"),
+	2.f,
+	TEXT("CPU time allowed to all Simple Procedural Walk nodes per frame, in milliseconds."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSPWGovernorHysteresis(
+	TEXT("SPW.Governor.Hysteresis"),
+	.25f,
+	TEXT("The quality is raised when the frame time is below the target by this fraction."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarSPWGovernorFrames(
+	TEXT("SPW.Governor.Frames"),
+	10,
+	TEXT("Consecutive frames over the target before lowering the quality (raising it takes three times as long)."),
+	ECVF_Default);
+
+namespace SimpleProceduralWalk_Governor
+{
+	struct FLevelSettings
+	{
+		float SignificanceScale;
+		float MaxIterationsScale;
+		int32 MinTraceInterval;
+		bool bForceBasicSolver;
+	};
+
+	static const FLevelSettings Levels[] = {
+		{ 1.f, 1.f, 1, false },
+		{ .75f, .75f, 1, false },
+		{ .5f, .5f, 2, true },
+		{ .35f, .35f, 3, true },
+		{ .25f, .25f, 4, true },
+	};
+
+	static const FLevelSettings& GetLevelSettings(int32 Level)
+	{
+		return Levels[FMath::Clamp(Level, 0, static_cast<int32>(UE_ARRAY_COUNT(Levels)) - 1)];
+	}
+}
+
+FSimpleProceduralWalk_Governor& FSimpleProceduralWalk_Governor::Get()
+{
+	static FSimpleProceduralWalk_Governor Governor;
+	return Governor;
+}
+
+void FSimpleProceduralWalk_Governor::BeginFrame(uint64 Frame)
+{
+	uint64 PreviousFrame = CurrentFrame.Load();
+	if (PreviousFrame == Frame || !CurrentFrame.CompareExchange(PreviousFrame, Frame))
+	{
+		// already closed
+		return;
+	}
+
+	const float FrameMs = FPlatformTime::ToMilliseconds64(FrameCycles.Exchange(0));
+	int32 NewLevel = Level.Load();
+
+	if (CVarSPWGovernorEnable.GetValueOnAnyThread() == 0)
+	{
+		NewLevel = 0;
+		FramesOverTarget = 0;
+		FramesUnderTarget = 0;
+	}
+	else
+	{
+		const float TargetMs = CVarSPWGovernorTargetMs.GetValueOnAnyThread();
+		const int32 NumFrames = FMath::Max(CVarSPWGovernorFrames.GetValueOnAnyThread(), 1);
+
+		// over target -> lower quality, well under target -> raise quality
+		FramesOverTarget = FrameMs > TargetMs ? FramesOverTarget + 1 : 0;
+		FramesUnderTarget = FrameMs < TargetMs * (1.f - CVarSPWGovernorHysteresis.GetValueOnAnyThread()) ? FramesUnderTarget + 1 : 0;
+
+		if (FramesOverTarget >= NumFrames)
+		{
+			NewLevel = FMath::Min(NewLevel + 1, static_cast<int32>(UE_ARRAY_COUNT(SimpleProceduralWalk_Governor::Levels)) - 1);
+			FramesOverTarget = 0;
+		}
+		else if (FramesUnderTarget >= NumFrames * 3)
+		{
+			NewLevel = FMath::Max(NewLevel - 1, 0);
+			FramesUnderTarget = 0;
+		}
+	}
+
+	if (NewLevel != Level.Load())
+	{
+		UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Governor level changed to %d (frame time: %f ms)."), NewLevel, FrameMs);
+		Level.Store(NewLevel);
+	}
+
+	SET_DWORD_STAT(STAT_SPW_GovernorLevel, NewLevel);
+	SET_FLOAT_STAT(STAT_SPW_GovernorFrameTime, FrameMs);
+}
+
+float FSimpleProceduralWalk_Governor::GetSignificanceScale() const
+{
+	return SimpleProceduralWalk_Governor::GetLevelSettings(GetLevel()).SignificanceScale;
+}
+
+float FSimpleProceduralWalk_Governor::GetMaxIterationsScale() const
+{
+	return SimpleProceduralWalk_Governor::GetLevelSettings(GetLevel()).MaxIterationsScale;
+}
+
+int32 FSimpleProceduralWalk_Governor::GetMinTraceInterval() const
+{
+	return SimpleProceduralWalk_Governor::GetLevelSettings(GetLevel()).MinTraceInterval;
+}
+
+bool FSimpleProceduralWalk_Governor::IsBasicSolverForced() const
+{
+	return SimpleProceduralWalk_Governor::GetLevelSettings(GetLevel()).bForceBasicSolver;
+}
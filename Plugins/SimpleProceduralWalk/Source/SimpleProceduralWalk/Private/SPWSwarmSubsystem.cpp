@@ -0,0 +1,193 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#include "SPWSwarmSubsystem.h"
+#include "Animation/Skeleton.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "SPWWalkProfile.h"
+
+// constants
+// (templates may be updated at a reduced rate)
+static const uint64 TEMPLATE_STALE_FRAMES = 30;
+
+
+void USPWSwarmSubsystem::FTemplate::CountClones(uint64 Frame)
+{
+	if (CloneCountFrame != Frame)
+	{
+		NumClonesPreviousFrame = CloneCountFrame + 1 == Frame ? NumClones : 0;
+		NumClones = 0;
+		CloneCountFrame = Frame;
+	}
+}
+
+USPWSwarmSubsystem::FCluster* USPWSwarmSubsystem::FindCluster(const USkeleton* Skeleton, const USPWWalkProfile* WalkProfile, bool bAdd)
+{
+	const FClusterKey ClusterKey(Skeleton, WalkProfile);
+
+	{
+		FReadScopeLock ReadLock(ClustersLock);
+		if (const TUniquePtr<FCluster>* Cluster = Clusters.Find(ClusterKey))
+		{
+			return Cluster->Get();
+		}
+	}
+
+	if (!bAdd)
+	{
+		return nullptr;
+	}
+
+	FWriteScopeLock WriteLock(ClustersLock);
+	TUniquePtr<FCluster>& Cluster = Clusters.FindOrAdd(ClusterKey);
+	if (!Cluster.IsValid())
+	{
+		Cluster = MakeUnique<FCluster>();
+	}
+	return Cluster.Get();
+}
+
+bool USPWSwarmSubsystem::PublishPose(const USkeleton* Skeleton
+	, const USPWWalkProfile* WalkProfile
+	, const USkeletalMeshComponent* TemplateComponent
+	, const FVector& Location
+	, FSimpleProceduralWalk_PoseSnapshotPtr* InOutSnapshot)
+{
+	FCluster* Cluster = FindCluster(Skeleton, WalkProfile, true);
+	FScopeLock Lock(&Cluster->CriticalSection);
+
+	TArray<FTemplate>& Templates = Cluster->Templates;
+	PruneTemplates(Templates, GFrameCounter);
+
+	FTemplate* Template = Templates.FindByPredicate([TemplateComponent](const FTemplate& Entry) {
+		return Entry.Component.Get() == TemplateComponent;
+	});
+	if (Template == nullptr)
+	{
+		Template = &Templates.AddDefaulted_GetRef();
+		Template->Component = TemplateComponent;
+		for (FSimpleProceduralWalk_PoseSnapshotPtr& Entry : Template->History)
+		{
+			Entry = MakeShared<FSimpleProceduralWalk_PoseSnapshot, ESPMode::ThreadSafe>();
+		}
+	}
+
+	Template->Location = Location;
+	Template->LastPublishFrame = GFrameCounter;
+
+	if (InOutSnapshot != nullptr && InOutSnapshot->IsValid())
+	{
+		// push to history, the oldest snapshot goes back to the template
+		Template->HistoryHead = (Template->HistoryHead + 1) % SPW_POSE_HISTORY;
+		Swap(Template->History[Template->HistoryHead], *InOutSnapshot);
+		Template->NumSnapshots = FMath::Min(Template->NumSnapshots + 1, SPW_POSE_HISTORY);
+	}
+	else
+	{
+		// registered only, history is outdated
+		Template->NumSnapshots = 0;
+	}
+
+	Template->CountClones(GFrameCounter);
+	return Template->NumClones > 0 || Template->NumClonesPreviousFrame > 0;
+}
+
+bool USPWSwarmSubsystem::CopyPose(const USkeleton* Skeleton
+	, const USPWWalkProfile* WalkProfile
+	, const USkeletalMeshComponent* CloneComponent
+	, const FVector& CloneLocation
+	, TWeakObjectPtr<const USkeletalMeshComponent>& InOutTemplateComponent
+	, int32 MaxClones
+	, float MaxDistance
+	, int32 PhaseDelay
+	, FSimpleProceduralWalk_PoseSnapshotConstPtr& OutSnapshot)
+{
+	FCluster* Cluster = FindCluster(Skeleton, WalkProfile, false);
+	if (Cluster == nullptr)
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&Cluster->CriticalSection);
+	TArray<FTemplate>* Templates = &Cluster->Templates;
+
+	const uint64 Frame = GFrameCounter;
+	PruneTemplates(*Templates, Frame);
+
+	// a template that had clones in the previous frame keeps computing its pose
+	FTemplate* SelfTemplate = Templates->FindByPredicate([CloneComponent](const FTemplate& Entry) {
+		return Entry.Component.Get() == CloneComponent;
+	});
+	if (SelfTemplate != nullptr)
+	{
+		SelfTemplate->CountClones(Frame);
+		if (SelfTemplate->NumClonesPreviousFrame > 0 || SelfTemplate->NumClones > 0)
+		{
+			InOutTemplateComponent.Reset();
+			return false;
+		}
+	}
+
+	// keep the previous template, or find the nearest one with room
+	FTemplate* Template = nullptr;
+	float TemplateDistanceSquared = MAX_flt;
+	for (FTemplate& Entry : *Templates)
+	{
+		if (&Entry == SelfTemplate)
+		{
+			continue;
+		}
+
+		const float DistanceSquared = FVector::DistSquared(Entry.Location, CloneLocation);
+		if (MaxDistance > 0.f && DistanceSquared > FMath::Square(MaxDistance))
+		{
+			continue;
+		}
+
+		Entry.CountClones(Frame);
+		if (Entry.Component == InOutTemplateComponent)
+		{
+			Template = &Entry;
+			break;
+		}
+		if (Entry.NumClones < MaxClones && DistanceSquared < TemplateDistanceSquared)
+		{
+			Template = &Entry;
+			TemplateDistanceSquared = DistanceSquared;
+		}
+	}
+
+	if (Template == nullptr)
+	{
+		InOutTemplateComponent.Reset();
+		return false;
+	}
+
+	Template->NumClones++;
+	InOutTemplateComponent = Template->Component;
+
+	// template only registered so far, publishes its pose from its next update
+	if (Template->NumSnapshots == 0)
+	{
+		return false;
+	}
+
+	// shared (never copied), with phase offset
+	const int32 Delay = FMath::Clamp(PhaseDelay, 0, Template->NumSnapshots - 1);
+	OutSnapshot = Template->History[(Template->HistoryHead - Delay + SPW_POSE_HISTORY) % SPW_POSE_HISTORY];
+
+	// no clones, stop being a template
+	if (SelfTemplate != nullptr)
+	{
+		Templates->RemoveAtSwap(SelfTemplate - Templates->GetData());
+	}
+
+	return true;
+}
+
+void USPWSwarmSubsystem::PruneTemplates(TArray<FTemplate>& Templates, uint64 Frame)
+{
+	// templates that stopped publishing (became clones, or were destroyed)
+	Templates.RemoveAllSwap([Frame](const FTemplate& Entry) {
+		return !Entry.Component.IsValid() || Entry.LastPublishFrame + TEMPLATE_STALE_FRAMES < Frame;
+	});
+}
@@ -0,0 +1,82 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#include "SPWWalkProfile.h"
+#include "Curves/CurveFloat.h"
+
+
+USPWWalkProfile::USPWWalkProfile()
+	: MinDistanceToUnplant(5.f)
+	, FixFeetTargetsAfterPercent(.5f)
+	, FeetTipBonesRotationInterpSpeed(15.f)
+	, StepCurveType(ESimpleProceduralWalk_StepCurveType::ROBOT)
+	, StepSlopeReductionMultiplier(.75f)
+	, MinStepDuration(0.15f)
+	, CustomStepHeightCurve()
+	, CustomStepDistanceCurve()
+	, BodyAccelerationRotationMultiplier(.1f)
+	, BodyFeetLocationsRotationMultiplier(.75f)
+	, MaxBodyRotation(FRotator(45.f, 0.f, 45.f))
+	, SolverType(ESimpleProceduralWalk_SolverType::ADVANCED)
+	, FeetInAirInterSpeed(15.f)
+	, RadiusCheckMultiplier(1.5f)
+	, DistanceCheckMultiplier(1.2f)
+	, Precision(1.f)
+	, MaxIterations(10)
+	, TraceChannel()
+	, TraceLength(350.f)
+	, bTraceComplex(true)
+	, TraceZOffset(50.f)
+{
+}
+
+void USPWWalkProfile::PostLoad()
+{
+	Super::PostLoad();
+
+	BakeDerivedData();
+}
+
+#if WITH_EDITOR
+void USPWWalkProfile::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	BakeDerivedData();
+}
+
+bool USPWWalkProfile::AreStepCurvesStale() const
+{
+	return StepCurveType == ESimpleProceduralWalk_StepCurveType::CUSTOM
+		&& CustomStepCurves.IsStale(CustomStepHeightCurve, CustomStepDistanceCurve);
+}
+
+void USPWWalkProfile::RebakeStaleStepCurves()
+{
+	if (AreStepCurvesStale())
+	{
+		BakeDerivedData();
+	}
+}
+#endif
+
+const FSimpleProceduralWalk_StepCurves& USPWWalkProfile::GetStepCurves() const
+{
+	return StepCurveType == ESimpleProceduralWalk_StepCurveType::CUSTOM
+		? CustomStepCurves
+		: FSimpleProceduralWalk_StepCurves::GetDefault(StepCurveType);
+}
+
+void USPWWalkProfile::BakeDerivedData()
+{
+	// bake custom curves, so that nodes never access the curve assets while evaluating
+	if (CustomStepHeightCurve != nullptr)
+	{
+		CustomStepHeightCurve->ConditionalPostLoad();
+	}
+	if (CustomStepDistanceCurve != nullptr)
+	{
+		CustomStepDistanceCurve->ConditionalPostLoad();
+	}
+
+	CustomStepCurves.Bake(CustomStepHeightCurve, CustomStepDistanceCurve);
+}
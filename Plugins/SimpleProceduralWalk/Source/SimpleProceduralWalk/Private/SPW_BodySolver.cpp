@@ -8,6 +8,8 @@ void FAnimNode_SPW::Evaluate_BodySolver(FComponentSpacePoseContext& Output)
 {
 	if (bIsInitialized && BodyBone.BoneIndex != INDEX_NONE && !bIsFalling)
 	{
+		SCOPE_CYCLE_COUNTER(STAT_SPW_BodySolver);
+
 		const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
 
 		FCompactPoseBoneIndex CompactPoseBoneToModify = BodyBone.GetCompactPoseIndex(BoneContainer);
@@ -16,32 +18,12 @@ void FAnimNode_SPW::Evaluate_BodySolver(FComponentSpacePoseContext& Output)
 		// \/ location
 		NewBoneTM.AddToTranslation(CurrentBodyRelLocation);
 
-		// \/ rotation
-		FRotator BoneRotation;
-
-		// switch on skeletal axis
-		switch (SkeletalMeshForwardAxis)
-		{
-		case ESimpleProceduralWalk_MeshForwardAxis::X:
-			BoneRotation = CurrentBodyRelRotation;
-			break;
-		case ESimpleProceduralWalk_MeshForwardAxis::NX:
-			BoneRotation = FRotator(-CurrentBodyRelRotation.Pitch, 0.f, -CurrentBodyRelRotation.Roll);
-			break;
-		case ESimpleProceduralWalk_MeshForwardAxis::Y:
-			BoneRotation = FRotator(CurrentBodyRelRotation.Roll, 0.f, -CurrentBodyRelRotation.Pitch);
-			break;
-		case ESimpleProceduralWalk_MeshForwardAxis::NY:
-			BoneRotation = FRotator(-CurrentBodyRelRotation.Roll, 0.f, CurrentBodyRelRotation.Pitch);
-			break;
-		}
-
-		const FQuat BoneQuat(BoneRotation);
-		NewBoneTM.SetRotation(BoneQuat * NewBoneTM.GetRotation());
+		// \/ rotation (already mapped on the skeletal axis)
+		NewBoneTM.SetRotation(CurrentBodyBoneRotation * NewBoneTM.GetRotation());
 
 		// merge
-		TArray<FBoneTransform> TempTransforms;
-		TempTransforms.Add(FBoneTransform(BodyBone.GetCompactPoseIndex(BoneContainer), NewBoneTM));
-		Output.Pose.LocalBlendCSBoneTransforms(TempTransforms, 1.f);
+		BodyBoneTransforms.Reset();
+		BodyBoneTransforms.Add(FBoneTransform(BodyBone.GetCompactPoseIndex(BoneContainer), NewBoneTM));
+		Output.Pose.LocalBlendCSBoneTransforms(BodyBoneTransforms, QualityTierBlendWeight);
 	}
 }
@@ -9,150 +9,423 @@
 void FAnimNode_SPW::Initialize_CCDIK()
 {
 	// resize
-	FeetRotationLimitsPerJoints.SetNum(Legs.Num());
+	// (rotation limits depend on the bones kept by the LOD, so they are set in InitializeBoneReferences)
+	CCDIKLegChains.SetNum(Legs.Num());
 
-	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
+	for (FSPW_CCDIKLegChain& LegChain : CCDIKLegChains)
 	{
-		FeetRotationLimitsPerJoints[LegIndex].RotationLimits = Legs[LegIndex].RotationLimitPerJoints;
+		LegChain.bIsCacheValid = false;
+	}
+}
 
+void FAnimNode_SPW::CCDIK_RemapRotationLimits(int32 LegIndex, const FBoneContainer& RequiredBones)
+{
+	const FSimpleProceduralWalk_Leg& Leg = Legs[LegIndex];
+	TArray<float>& RotationLimits = FeetRotationLimitsPerJoints[LegIndex].RotationLimits;
+
+	if (Leg.RotationLimitPerJoints.Num() == 0 || Leg.ParentBone.BoneIndex == INDEX_NONE || Leg.TipBone.BoneIndex == INDEX_NONE)
+	{
+		// parent's parent
 		// (the fact that this bone has root is checked during saving)
-		FeetRotationLimitsPerJoints[LegIndex].RotationLimits.Insert(0.f, 0);
+		RotationLimits.Reset();
+		RotationLimits.Add(0.f);
+		return;
 	}
+
+	// bones from parent bone to tip bone
+	const FReferenceSkeleton& RefSkeleton = RequiredBones.GetReferenceSkeleton();
+	TArray<int32, TInlineAllocator<16>> BoneIndices;
+
+	for (int32 BoneIndex = Leg.TipBone.BoneIndex; BoneIndex != INDEX_NONE; BoneIndex = RefSkeleton.GetParentIndex(BoneIndex))
+	{
+		BoneIndices.Insert(BoneIndex, 0);
+		if (BoneIndex == Leg.ParentBone.BoneIndex)
+		{
+			break;
+		}
+	}
+
+	// bones removed by LOD
+	TArray<bool, TInlineAllocator<16>> bIsJointRequired;
+	for (const int32 BoneIndex : BoneIndices)
+	{
+		bIsJointRequired.Add(RequiredBones.Contains(static_cast<FBoneIndexType>(BoneIndex)));
+	}
+
+	SimpleProceduralWalk_RotationLimits::Remap(Leg.RotationLimitPerJoints, bIsJointRequired, RotationLimits);
 }
 
 void FAnimNode_SPW::Evaluate_CCDIKSolver(FComponentSpacePoseContext& Output)
 {
 	if (bIsInitialized)
 	{
-		// container
-		const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
+		SCOPE_CYCLE_COUNTER(STAT_SPW_CCDIKSolver);
+
+		// resize
+		CCDIKLegChains.SetNum(Legs.Num());
+
+		// gather all chains first, so that legs can be solved together
+		for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
+		{
+			CCDIK_GatherChain(Output, LegIndex);
+		}
 
-		// partial transforms
-		TArray<FBoneTransform> TempTransforms;
+		// solve
+		const uint32 SolveStartCycles = FPlatformTime::Cycles();
+		int32 LaneLegIndices[SPW_CCDIK_LANES];
+		int32 NumLanes = 0;
 
 		for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
 		{
-			TempTransforms.Reset();
+			FSPW_CCDIKLegChain& LegChain = CCDIKLegChains[LegIndex];
 
-			// do not perform IK if it's disabled
-			if (!LegsData[LegIndex].bEnableIK)
+			if (!LegChain.bIsGathered || LegChain.bIsCacheHit)
 			{
 				continue;
 			}
 
-			// Update EffectorLocation if it is based off a bone position
-			FVector EffectorLocation(LegsData[LegIndex].FootLocation);
-
-			FTransform CSEffectorTransform = CCDIK_GetTargetTransform(Output.AnimInstanceProxy->GetComponentTransform()
-				, Output.Pose
-				, EffectorTargets[LegIndex]
-				, EffectorLocation);
-			FVector const CSEffectorLocation = CSEffectorTransform.GetLocation();
-
-			// Gather all bone indices between root and tip.
-			TArray<FCompactPoseBoneIndex> BoneIndices;
+			INC_DWORD_STAT(STAT_SPW_CCDIKSolvedLegs);
 
+			if (bVectorizedSolver && CCDIK_CanSolveInLanes(LegIndex))
 			{
-				const FCompactPoseBoneIndex RootIndex = ParentBones[LegIndex].GetCompactPoseIndex(BoneContainer);
-				FCompactPoseBoneIndex BoneIndex = TipBones[LegIndex].GetCompactPoseIndex(BoneContainer);
-				do
+				/* -> add to batch (settings are set when the batch is solved) */
+				LaneLegIndices[NumLanes++] = LegIndex;
+				if (NumLanes == SPW_CCDIK_LANES)
 				{
-					BoneIndices.Insert(BoneIndex, 0);
-					BoneIndex = Output.Pose.GetPose().GetParentBoneIndex(BoneIndex);
-				} while (BoneIndex != RootIndex);
-				BoneIndices.Insert(BoneIndex, 0);
+					CCDIK_SolveLanes(LaneLegIndices, NumLanes, SolveStartCycles);
+					NumLanes = 0;
+				}
+			}
+			else
+			{
+				/* -> per-leg solver */
+				CCDIK_SetLegSolverSettings(LegIndex, CCDIK_IsOverTimeBudget(SolveStartCycles));
+
+				LegChain.bBoneLocationUpdated = SolveCCDIK(LegChain.Chain
+					, LegChain.EffectorLocation
+					, Legs[LegIndex].bEnableRotationLimits
+					, FeetRotationLimitsPerJoints[LegIndex].RotationLimits
+					, LegChain.Precision
+					, LegChain.MaxIterations
+					, LegChain.Iterations
+					, LegChain.ResidualError);
+
+				INC_DWORD_STAT_BY(STAT_SPW_CCDIKIterations, LegChain.Iterations);
 			}
+		}
 
-			// Gather transforms
-			int32 const NumTransforms = BoneIndices.Num();
-			TempTransforms.AddUninitialized(NumTransforms);
+		// remaining batch
+		if (NumLanes > 0)
+		{
+			CCDIK_SolveLanes(LaneLegIndices, NumLanes, SolveStartCycles);
+		}
 
-			// Gather chain links. These are non zero length bones.
-			TArray<FSPW_CCDIKChainLink> Chain;
-			Chain.Reserve(NumTransforms);
-			// Start with Root Bone
+		// apply
+		for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
+		{
+			if (CCDIKLegChains[LegIndex].bIsGathered)
 			{
-				const FCompactPoseBoneIndex& RootBoneIndex = BoneIndices[0];
-				const FTransform& LocalTransform = Output.Pose.GetLocalSpaceTransform(RootBoneIndex);
-				const FTransform& BoneCSTransform = Output.Pose.GetComponentSpaceTransform(RootBoneIndex);
-
-				TempTransforms[0] = FBoneTransform(RootBoneIndex, BoneCSTransform);
-				Chain.Add(FSPW_CCDIKChainLink(BoneCSTransform, LocalTransform, 0));
+				CCDIK_ApplyChain(Output, LegIndex);
 			}
+		}
+	}
+}
 
-			// Go through remaining transforms
-			for (int32 TransformIndex = 1; TransformIndex < NumTransforms; TransformIndex++)
-			{
-				const FCompactPoseBoneIndex& BoneIndex = BoneIndices[TransformIndex];
+void FAnimNode_SPW::CCDIK_GatherChain(FComponentSpacePoseContext& Output, int32 LegIndex)
+{
+	FSPW_CCDIKLegChain& LegChain = CCDIKLegChains[LegIndex];
+	LegChain.bIsGathered = false;
+	LegChain.bBoneLocationUpdated = false;
+	LegChain.bIsCacheHit = false;
+
+	// do not perform IK if it's disabled, or if the leg has been removed by LOD
+	if (!LegsData.HasFlag(LegIndex, ESimpleProceduralWalk_LegFlags::EnableIK) || !LegsChainValid[LegIndex])
+	{
+		LegChain.bIsCacheValid = false;
+		return;
+	}
 
-				const FTransform& LocalTransform = Output.Pose.GetLocalSpaceTransform(BoneIndex);
-				const FTransform& BoneCSTransform = Output.Pose.GetComponentSpaceTransform(BoneIndex);
-				FVector const BoneCSPosition = BoneCSTransform.GetLocation();
+	// container
+	const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
 
-				TempTransforms[TransformIndex] = FBoneTransform(BoneIndex, BoneCSTransform);
+	// Update EffectorLocation if it is based off a bone position
+	FVector EffectorLocation(LegsData.FootLocations[LegIndex]);
 
-				// Calculate the combined length of this segment of skeleton
-				float const BoneLength = FVector::Dist(BoneCSPosition, TempTransforms[TransformIndex - 1].Transform.GetLocation());
+	FTransform CSEffectorTransform = CCDIK_GetTargetTransform(Output.AnimInstanceProxy->GetComponentTransform()
+		, Output.Pose
+		, EffectorTargets[LegIndex]
+		, EffectorLocation);
+	LegChain.EffectorLocation = CSEffectorTransform.GetLocation();
 
-				if (!FMath::IsNearlyZero(BoneLength))
-				{
-					Chain.Add(FSPW_CCDIKChainLink(BoneCSTransform, LocalTransform, TransformIndex));
-				}
-				else
-				{
-					// Mark this transform as a zero length child of the last link.
-					// It will inherit position and delta rotation from parent link.
-					FSPW_CCDIKChainLink & ParentLink = Chain[Chain.Num() - 1];
-					ParentLink.ChildZeroLengthTransformIndices.Add(TransformIndex);
-				}
-			}
+	// Gather all bone indices between root and tip.
+	TArray<FCompactPoseBoneIndex>& BoneIndices = LegChain.BoneIndices;
+	BoneIndices.Reset();
 
-			// solve
-			bool bBoneLocationUpdated = SolveCCDIK(Chain
-				, CSEffectorLocation
-				, Legs[LegIndex].bEnableRotationLimits
-				, FeetRotationLimitsPerJoints[LegIndex].RotationLimits);
+	{
+		const FCompactPoseBoneIndex RootIndex = ParentBones[LegIndex].GetCompactPoseIndex(BoneContainer);
+		FCompactPoseBoneIndex BoneIndex = TipBones[LegIndex].GetCompactPoseIndex(BoneContainer);
+		do
+		{
+			BoneIndices.Insert(BoneIndex, 0);
+			BoneIndex = Output.Pose.GetPose().GetParentBoneIndex(BoneIndex);
+		} while (BoneIndex != RootIndex);
+		BoneIndices.Insert(BoneIndex, 0);
+	}
 
-			// If we moved some bones, update bone transforms.
-			if (bBoneLocationUpdated)
-			{
-				int32 NumChainLinks = Chain.Num();
+	// Gather transforms
+	TArray<FBoneTransform>& TempTransforms = LegChain.Transforms;
+	int32 const NumTransforms = BoneIndices.Num();
+	TempTransforms.Reset();
+	TempTransforms.AddUninitialized(NumTransforms);
 
-				// First step: update bone transform positions from chain links.
-				for (int32 LinkIndex = 0; LinkIndex < NumChainLinks; LinkIndex++)
-				{
-					FSPW_CCDIKChainLink const & ChainLink = Chain[LinkIndex];
-					TempTransforms[ChainLink.TransformIndex].Transform = ChainLink.Transform;
+	for (int32 TransformIndex = 0; TransformIndex < NumTransforms; TransformIndex++)
+	{
+		TempTransforms[TransformIndex] = FBoneTransform(BoneIndices[TransformIndex], Output.Pose.GetComponentSpaceTransform(BoneIndices[TransformIndex]));
+	}
 
-					// If there are any zero length children, update position of those
-					int32 const NumChildren = ChainLink.ChildZeroLengthTransformIndices.Num();
-					for (int32 ChildIndex = 0; ChildIndex < NumChildren; ChildIndex++)
-					{
-						TempTransforms[ChainLink.ChildZeroLengthTransformIndices[ChildIndex]].Transform = ChainLink.Transform;
-					}
-				}
-			}
+	LegChain.bIsGathered = true;
+
+	// settings of the current quality (without the time budget, checked when solving)
+	CCDIK_SetLegSolverSettings(LegIndex, false);
 
-			// rotate tip bone
-			FCompactPoseBoneIndex CompactPoseBoneToModify = Legs[LegIndex].TipBone.GetCompactPoseIndex(BoneContainer);
-			FTransform ComponentTransform = Output.AnimInstanceProxy->GetComponentTransform();
-			int32 const TipBoneTransformIndex = TempTransforms.Num() - 1;
+	// nothing changed since last solve -> reuse the cached solution
+	if (bCacheSolvedLegs && CCDIK_IsCachedSolutionValid(LegIndex))
+	{
+		LegChain.bIsCacheHit = true;
+		LegChain.Iterations = 0;
+		LegChain.ResidualError = LegChain.CachedResidualError;
+		CCDIKCacheHits++;
+		INC_DWORD_STAT(STAT_SPW_CCDIKCachedLegs);
+		return;
+	}
+
+	if (bCacheSolvedLegs)
+	{
+		CCDIKCacheMisses++;
+		CCDIK_SetCachedSolutionInputs(LegIndex);
+	}
 
-			// convert to Bone Space.
-			FAnimationRuntime::ConvertCSTransformToBoneSpace(ComponentTransform, Output.Pose, TempTransforms[TipBoneTransformIndex].Transform, CompactPoseBoneToModify, BCS_ComponentSpace);
+	// Gather chain links. These are non zero length bones.
+	TArray<FSPW_CCDIKChainLink>& Chain = LegChain.Chain;
+	Chain.Reset();
+	Chain.Reserve(NumTransforms);
+	// Start with Root Bone
+	{
+		const FCompactPoseBoneIndex& RootBoneIndex = BoneIndices[0];
+		const FTransform& LocalTransform = Output.Pose.GetLocalSpaceTransform(RootBoneIndex);
+
+		Chain.Add(FSPW_CCDIKChainLink(TempTransforms[0].Transform, LocalTransform, 0));
+	}
+
+	// Go through remaining transforms
+	for (int32 TransformIndex = 1; TransformIndex < NumTransforms; TransformIndex++)
+	{
+		const FCompactPoseBoneIndex& BoneIndex = BoneIndices[TransformIndex];
 
-			const FQuat BoneQuat(LegsData[LegIndex].FootTargetRotation);
-			TempTransforms[TipBoneTransformIndex].Transform.SetRotation(BoneQuat * TempTransforms[TipBoneTransformIndex].Transform.GetRotation());
+		const FTransform& LocalTransform = Output.Pose.GetLocalSpaceTransform(BoneIndex);
+		const FTransform& BoneCSTransform = TempTransforms[TransformIndex].Transform;
+		FVector const BoneCSPosition = BoneCSTransform.GetLocation();
 
-			// convert back to Component Space.
-			FAnimationRuntime::ConvertBoneSpaceTransformToCS(ComponentTransform, Output.Pose, TempTransforms[TipBoneTransformIndex].Transform, CompactPoseBoneToModify, BCS_ComponentSpace);
+		// Calculate the combined length of this segment of skeleton
+		float const BoneLength = FVector::Dist(BoneCSPosition, TempTransforms[TransformIndex - 1].Transform.GetLocation());
 
-			// merge before looping
-			Output.Pose.LocalBlendCSBoneTransforms(TempTransforms, 1.f);
+		if (!FMath::IsNearlyZero(BoneLength))
+		{
+			Chain.Add(FSPW_CCDIKChainLink(BoneCSTransform, LocalTransform, TransformIndex));
+		}
+		else
+		{
+			// Mark this transform as a zero length child of the last link.
+			// It will inherit position and delta rotation from parent link.
+			FSPW_CCDIKChainLink & ParentLink = Chain[Chain.Num() - 1];
+			ParentLink.ChildZeroLengthTransformIndices.Add(TransformIndex);
 		}
 	}
 }
 
+bool FAnimNode_SPW::CCDIK_IsCachedSolutionValid(int32 LegIndex)
+{
+	const FSPW_CCDIKLegChain& LegChain = CCDIKLegChains[LegIndex];
+
+	if (!LegChain.bIsCacheValid || LegChain.CachedInputTransforms.Num() != LegChain.Transforms.Num())
+	{
+		return false;
+	}
+
+	// solved with coarser settings than the current ones (for instance in a lower quality tier)
+	if (LegChain.CachedPrecision > LegChain.Precision || LegChain.CachedMaxIterations < LegChain.MaxIterations)
+	{
+		return false;
+	}
+
+	// rotation tolerance, compared to 1 - |dot| (about angle^2 / 8 for small angles)
+	const float RotationTolerance = FMath::Square(FMath::DegreesToRadians(CacheTolerance)) / 8.f;
+
+	// target
+	if (!LegChain.EffectorLocation.Equals(LegChain.CachedEffectorLocation, CacheTolerance)
+		|| 1.f - FMath::Abs(LegsData.FootTargetRotations[LegIndex] | LegChain.CachedFootTargetRotation) > RotationTolerance)
+	{
+		return false;
+	}
+
+	// body
+	if (!CurrentBodyRelLocation.Equals(LegChain.CachedBodyRelLocation, CacheTolerance)
+		|| 1.f - FMath::Abs(CurrentBodyRelRotation | LegChain.CachedBodyRelRotation) > RotationTolerance)
+	{
+		return false;
+	}
+
+	// input pose
+	for (int32 TransformIndex = 0; TransformIndex < LegChain.Transforms.Num(); TransformIndex++)
+	{
+		if (!LegChain.Transforms[TransformIndex].Transform.Equals(LegChain.CachedInputTransforms[TransformIndex], CacheTolerance))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void FAnimNode_SPW::CCDIK_SetCachedSolutionInputs(int32 LegIndex)
+{
+	FSPW_CCDIKLegChain& LegChain = CCDIKLegChains[LegIndex];
+
+	LegChain.CachedEffectorLocation = LegChain.EffectorLocation;
+	LegChain.CachedFootTargetRotation = LegsData.FootTargetRotations[LegIndex];
+	LegChain.CachedBodyRelLocation = CurrentBodyRelLocation;
+	LegChain.CachedBodyRelRotation = CurrentBodyRelRotation;
+
+	LegChain.CachedInputTransforms.SetNum(LegChain.Transforms.Num(), false);
+	for (int32 TransformIndex = 0; TransformIndex < LegChain.Transforms.Num(); TransformIndex++)
+	{
+		LegChain.CachedInputTransforms[TransformIndex] = LegChain.Transforms[TransformIndex].Transform;
+	}
+
+	// solution will be stored once applied
+	LegChain.bIsCacheValid = false;
+}
+
+void FAnimNode_SPW::CCDIK_ApplyChain(FComponentSpacePoseContext& Output, int32 LegIndex)
+{
+	FSPW_CCDIKLegChain& LegChain = CCDIKLegChains[LegIndex];
+	TArray<FBoneTransform>& TempTransforms = LegChain.Transforms;
+
+	if (LegChain.bIsCacheHit)
+	{
+		/* -> nothing changed, output the cached solution */
+		Output.Pose.LocalBlendCSBoneTransforms(LegChain.CachedOutputTransforms, QualityTierBlendWeight);
+		return;
+	}
+
+	// container
+	const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
+
+	// If we moved some bones, update bone transforms.
+	if (LegChain.bBoneLocationUpdated)
+	{
+		int32 NumChainLinks = LegChain.Chain.Num();
+
+		// First step: update bone transform positions from chain links.
+		for (int32 LinkIndex = 0; LinkIndex < NumChainLinks; LinkIndex++)
+		{
+			FSPW_CCDIKChainLink const & ChainLink = LegChain.Chain[LinkIndex];
+			TempTransforms[ChainLink.TransformIndex].Transform = ChainLink.Transform;
+
+			// If there are any zero length children, update position of those
+			int32 const NumChildren = ChainLink.ChildZeroLengthTransformIndices.Num();
+			for (int32 ChildIndex = 0; ChildIndex < NumChildren; ChildIndex++)
+			{
+				TempTransforms[ChainLink.ChildZeroLengthTransformIndices[ChildIndex]].Transform = ChainLink.Transform;
+			}
+		}
+	}
+
+	// rotate tip bone
+	FCompactPoseBoneIndex CompactPoseBoneToModify = TipBones[LegIndex].GetCompactPoseIndex(BoneContainer);
+	FTransform ComponentTransform = Output.AnimInstanceProxy->GetComponentTransform();
+	int32 const TipBoneTransformIndex = TempTransforms.Num() - 1;
+
+	// convert to Bone Space.
+	FAnimationRuntime::ConvertCSTransformToBoneSpace(ComponentTransform, Output.Pose, TempTransforms[TipBoneTransformIndex].Transform, CompactPoseBoneToModify, BCS_ComponentSpace);
+
+	const FQuat& BoneQuat = LegsData.FootTargetRotations[LegIndex];
+	TempTransforms[TipBoneTransformIndex].Transform.SetRotation(BoneQuat * TempTransforms[TipBoneTransformIndex].Transform.GetRotation());
+
+	// convert back to Component Space.
+	FAnimationRuntime::ConvertBoneSpaceTransformToCS(ComponentTransform, Output.Pose, TempTransforms[TipBoneTransformIndex].Transform, CompactPoseBoneToModify, BCS_ComponentSpace);
+
+	// store solution
+	if (bCacheSolvedLegs)
+	{
+		LegChain.CachedOutputTransforms = TempTransforms;
+		LegChain.CachedPrecision = LegChain.Precision;
+		LegChain.CachedMaxIterations = LegChain.MaxIterations;
+		LegChain.CachedResidualError = LegChain.ResidualError;
+		LegChain.bIsCacheValid = true;
+	}
+
+	// merge
+	Output.Pose.LocalBlendCSBoneTransforms(TempTransforms, QualityTierBlendWeight);
+}
+
+void FAnimNode_SPW::CCDIK_SolveLanes(const int32* LaneLegIndices, int32 NumLanes, uint32 SolveStartCycles)
+{
+	// precision & iterations, for the whole batch (budget checked when the batch is solved)
+	const bool bIsOverTimeBudget = CCDIK_IsOverTimeBudget(SolveStartCycles);
+	for (int32 Lane = 0; Lane < NumLanes; Lane++)
+	{
+		CCDIK_SetLegSolverSettings(LaneLegIndices[Lane], bIsOverTimeBudget);
+	}
+
+	SolveCCDIKLanes(LaneLegIndices, NumLanes);
+}
+
+bool FAnimNode_SPW::CCDIK_IsOverTimeBudget(uint32 StartCycles)
+{
+	if (!bAdaptiveIterations || TimeBudgetMicroseconds <= 0.f)
+	{
+		return false;
+	}
+
+	return FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - StartCycles) * 1000.f > TimeBudgetMicroseconds;
+}
+
+void FAnimNode_SPW::CCDIK_SetLegSolverSettings(int32 LegIndex, bool bIsOverTimeBudget)
+{
+	FSPW_CCDIKLegChain& LegChain = CCDIKLegChains[LegIndex];
+
+	if (!bAdaptiveIterations)
+	{
+		LegChain.Precision = GetPrecision();
+		LegChain.MaxIterations = GetMaxIterations();
+	}
+	else if (bIsOverTimeBudget)
+	{
+		/* -> budget spent, coarsest settings */
+		LegChain.Precision = FMath::Max(GetPrecision(), FarPrecision);
+		LegChain.MaxIterations = FMath::Min(GetMaxIterations(), FarMaxIterations);
+	}
+	else
+	{
+		/* -> scale with view distance */
+		const float FarAlpha = FMath::GetMappedRangeValueClamped(FVector2D(AdaptiveNearDistance, FMath::Max(AdaptiveFarDistance, AdaptiveNearDistance + 1.f))
+			, FVector2D(0.f, 1.f)
+			, FMath::Max(ViewDistance, 0.f));
+
+		LegChain.Precision = FMath::Lerp(GetPrecision(), FMath::Max(GetPrecision(), FarPrecision), FarAlpha);
+		LegChain.MaxIterations = FMath::RoundToInt(FMath::Lerp(static_cast<float>(GetMaxIterations()), static_cast<float>(FMath::Min(GetMaxIterations(), FarMaxIterations)), FarAlpha));
+	}
+
+	// scalability & governor
+	LegChain.Precision *= FSimpleProceduralWalk_Scalability::GetPrecisionScale();
+	LegChain.MaxIterations = FMath::Max(FMath::RoundToInt(LegChain.MaxIterations
+		* FSimpleProceduralWalk_Scalability::GetMaxIterationsScale()
+		* FSimpleProceduralWalk_Governor::Get().GetMaxIterationsScale()), 1);
+
+	LegChain.Iterations = 0;
+}
+
 FTransform FAnimNode_SPW::CCDIK_GetTargetTransform(const FTransform& InComponentTransform, FCSPose<FCompactPose>& MeshBases, FBoneSocketTarget& InTarget, const FVector& InOffset)
 {
 	FTransform OutTransform;
@@ -165,7 +438,8 @@ FTransform FAnimNode_SPW::CCDIK_GetTargetTransform(const FTransform& InComponent
 	return OutTransform;
 }
 
-bool FAnimNode_SPW::SolveCCDIK(TArray<FSPW_CCDIKChainLink>& InOutChain, const FVector& TargetPosition, bool bEnableRotationLimit, const TArray<float>& RotationLimitPerJoints)
+bool FAnimNode_SPW::SolveCCDIK(TArray<FSPW_CCDIKChainLink>& InOutChain, const FVector& TargetPosition, bool bEnableRotationLimit, const TArray<float>& RotationLimitPerJoints
+	, float InPrecision, int32 InMaxIterations, int32& OutIterations, float& OutResidualError)
 {
 	struct Local
 	{
@@ -188,7 +462,7 @@ bool FAnimNode_SPW::SolveCCDIK(TArray<FSPW_CCDIKChainLink>& InOutChain, const FV
 				ToEnd.Normalize();
 				ToTarget.Normalize();
 
-				float RotationLimitPerJointInRadian = FMath::DegreesToRadians(InRotationLimitPerJoints[LinkIndex]);
+				float RotationLimitPerJointInRadian = InRotationLimitPerJoints[LinkIndex];
 				float Angle = FMath::ClampAngle(FMath::Acos(FVector::DotProduct(ToEnd, ToTarget)), -RotationLimitPerJointInRadian, RotationLimitPerJointInRadian);
 				bool bCanRotate = (FMath::Abs(Angle) > KINDA_SMALL_NUMBER) && (!bInEnableRotationLimit || RotationLimitPerJointInRadian > CurrentLink.CurrentAngleDelta);
 				if (bCanRotate)
@@ -270,8 +544,11 @@ bool FAnimNode_SPW::SolveCCDIK(TArray<FSPW_CCDIKChainLink>& InOutChain, const FV
 		FVector TipPos = InOutChain[TipBoneLinkIndex].Transform.GetLocation();
 		float Distance = FVector::Dist(TargetPos, TipPos);
 		int32 IterationCount = 0;
-		while ((Distance > Precision) && (IterationCount++ < MaxIterations))
+		OutIterations = 0;
+		while ((Distance > InPrecision) && (IterationCount++ < InMaxIterations))
 		{
+			OutIterations++;
+
 			// iterate from tip to root
 			if (bStartFromTail)
 			{
@@ -298,6 +575,8 @@ bool FAnimNode_SPW::SolveCCDIK(TArray<FSPW_CCDIKChainLink>& InOutChain, const FV
 				break;
 			}
 		}
+
+		OutResidualError = Distance;
 	}
 
 	return bBoneLocationUpdated;
@@ -0,0 +1,371 @@
+// Copyright Epic Games, Inc. and Roberto Ostinelli, 2021. All Rights Reserved.
+
+#include "SPW_CCDIKSolver.h"
+#include "AnimNode_SPW.h"
+
+
+namespace SPW_CCDIKLanes
+{
+	/** Normalizes a SoA vector, leaving (almost) zero length vectors untouched. */
+	FORCEINLINE void Normalize(VectorRegister& X, VectorRegister& Y, VectorRegister& Z)
+	{
+		const VectorRegister SizeSquared = VectorMultiplyAdd(X, X, VectorMultiplyAdd(Y, Y, VectorMultiply(Z, Z)));
+		const VectorRegister IsValid = VectorCompareGT(SizeSquared, VectorSetFloat1(SMALL_NUMBER));
+		const VectorRegister InvSize = VectorReciprocalSqrtAccurate(VectorMax(SizeSquared, VectorSetFloat1(SMALL_NUMBER)));
+
+		X = VectorSelect(IsValid, VectorMultiply(X, InvSize), X);
+		Y = VectorSelect(IsValid, VectorMultiply(Y, InvSize), Y);
+		Z = VectorSelect(IsValid, VectorMultiply(Z, InvSize), Z);
+	}
+
+	/** Normalizes a SoA quaternion. */
+	FORCEINLINE void NormalizeQuat(VectorRegister& X, VectorRegister& Y, VectorRegister& Z, VectorRegister& W)
+	{
+		const VectorRegister SizeSquared = VectorMultiplyAdd(X, X, VectorMultiplyAdd(Y, Y, VectorMultiplyAdd(Z, Z, VectorMultiply(W, W))));
+		const VectorRegister InvSize = VectorReciprocalSqrtAccurate(VectorMax(SizeSquared, VectorSetFloat1(SMALL_NUMBER)));
+
+		X = VectorMultiply(X, InvSize);
+		Y = VectorMultiply(Y, InvSize);
+		Z = VectorMultiply(Z, InvSize);
+		W = VectorMultiply(W, InvSize);
+	}
+
+	/** Rotates the lanes of a link by the delta quaternion, where the mask is set. */
+	FORCEINLINE void RotateLink(FSPW_CCDIKLinkLanes& Link
+		, const VectorRegister& Mask
+		, const VectorRegister& DX, const VectorRegister& DY, const VectorRegister& DZ, const VectorRegister& DW)
+	{
+		// Delta * Rotation
+		VectorRegister X = VectorMultiplyAdd(DW, Link.RotationX, VectorMultiplyAdd(DX, Link.RotationW, VectorSubtract(VectorMultiply(DY, Link.RotationZ), VectorMultiply(DZ, Link.RotationY))));
+		VectorRegister Y = VectorMultiplyAdd(DW, Link.RotationY, VectorMultiplyAdd(DY, Link.RotationW, VectorSubtract(VectorMultiply(DZ, Link.RotationX), VectorMultiply(DX, Link.RotationZ))));
+		VectorRegister Z = VectorMultiplyAdd(DW, Link.RotationZ, VectorMultiplyAdd(DZ, Link.RotationW, VectorSubtract(VectorMultiply(DX, Link.RotationY), VectorMultiply(DY, Link.RotationX))));
+		VectorRegister W = VectorSubtract(VectorMultiply(DW, Link.RotationW), VectorMultiplyAdd(DX, Link.RotationX, VectorMultiplyAdd(DY, Link.RotationY, VectorMultiply(DZ, Link.RotationZ))));
+		NormalizeQuat(X, Y, Z, W);
+
+		Link.RotationX = VectorSelect(Mask, X, Link.RotationX);
+		Link.RotationY = VectorSelect(Mask, Y, Link.RotationY);
+		Link.RotationZ = VectorSelect(Mask, Z, Link.RotationZ);
+		Link.RotationW = VectorSelect(Mask, W, Link.RotationW);
+	}
+
+	/** Rotates the lanes of a link location around a pivot by the delta quaternion, where the mask is set. */
+	FORCEINLINE void RotateLinkLocation(FSPW_CCDIKLinkLanes& Link
+		, const VectorRegister& Mask
+		, const VectorRegister& PX, const VectorRegister& PY, const VectorRegister& PZ
+		, const VectorRegister& DX, const VectorRegister& DY, const VectorRegister& DZ, const VectorRegister& DW)
+	{
+		const VectorRegister VX = VectorSubtract(Link.LocationX, PX);
+		const VectorRegister VY = VectorSubtract(Link.LocationY, PY);
+		const VectorRegister VZ = VectorSubtract(Link.LocationZ, PZ);
+
+		// T = 2 * (Q x V)
+		const VectorRegister Two = VectorSetFloat1(2.f);
+		const VectorRegister TX = VectorMultiply(Two, VectorSubtract(VectorMultiply(DY, VZ), VectorMultiply(DZ, VY)));
+		const VectorRegister TY = VectorMultiply(Two, VectorSubtract(VectorMultiply(DZ, VX), VectorMultiply(DX, VZ)));
+		const VectorRegister TZ = VectorMultiply(Two, VectorSubtract(VectorMultiply(DX, VY), VectorMultiply(DY, VX)));
+
+		// V' = V + W * T + (Q x T)
+		const VectorRegister RX = VectorAdd(VectorMultiplyAdd(DW, TX, VX), VectorSubtract(VectorMultiply(DY, TZ), VectorMultiply(DZ, TY)));
+		const VectorRegister RY = VectorAdd(VectorMultiplyAdd(DW, TY, VY), VectorSubtract(VectorMultiply(DZ, TX), VectorMultiply(DX, TZ)));
+		const VectorRegister RZ = VectorAdd(VectorMultiplyAdd(DW, TZ, VZ), VectorSubtract(VectorMultiply(DX, TY), VectorMultiply(DY, TX)));
+
+		Link.LocationX = VectorSelect(Mask, VectorAdd(PX, RX), Link.LocationX);
+		Link.LocationY = VectorSelect(Mask, VectorAdd(PY, RY), Link.LocationY);
+		Link.LocationZ = VectorSelect(Mask, VectorAdd(PZ, RZ), Link.LocationZ);
+	}
+
+	/** Creates a lane mask from booleans. */
+	FORCEINLINE VectorRegister MakeMask(const bool* bLanes)
+	{
+		return VectorCompareGT(MakeVectorRegister(bLanes[0] ? 1.f : 0.f, bLanes[1] ? 1.f : 0.f, bLanes[2] ? 1.f : 0.f, bLanes[3] ? 1.f : 0.f), VectorZero());
+	}
+}
+
+static_assert(SPW_CCDIK_LANES == 4, "SPW_CCDIKLanes::MakeMask assumes 4 lanes.");
+
+
+bool FAnimNode_SPW::CCDIK_CanSolveInLanes(int32 LegIndex)
+{
+	const FSPW_CCDIKLegChain& LegChain = CCDIKLegChains[LegIndex];
+
+	// nothing to solve
+	if (LegChain.Chain.Num() < 3)
+	{
+		return false;
+	}
+
+	// rotation limits must be available for all links (i.e. no Virtual Bones), the per-leg solver reports the error otherwise
+	return LegChain.Chain.Num() - 1 <= FeetRotationLimitsPerJoints[LegIndex].RotationLimits.Num();
+}
+
+void FAnimNode_SPW::SolveCCDIKLanes(const int32* LaneLegIndices, int32 NumLanes)
+{
+	using namespace SPW_CCDIKLanes;
+
+	// lanes setup
+	int32 NumLinks[SPW_CCDIK_LANES] = { 0 };
+	int32 MaxNumLinks = 0;
+
+	for (int32 Lane = 0; Lane < NumLanes; Lane++)
+	{
+		NumLinks[Lane] = CCDIKLegChains[LaneLegIndices[Lane]].Chain.Num();
+		MaxNumLinks = FMath::Max(MaxNumLinks, NumLinks[Lane]);
+	}
+
+	CCDIKLinkLanes.SetNumUninitialized(MaxNumLinks, false);
+
+	// pack chains, aligned on tip
+	for (int32 Row = 0; Row < MaxNumLinks; Row++)
+	{
+		float Values[9][SPW_CCDIK_LANES] = { { 0.f } };
+		bool bCanSolve[SPW_CCDIK_LANES] = { false };
+
+		for (int32 Lane = 0; Lane < NumLanes; Lane++)
+		{
+			const int32 LegIndex = LaneLegIndices[Lane];
+			const int32 LinkIndex = Row - (MaxNumLinks - NumLinks[Lane]);
+
+			if (LinkIndex < 0)
+			{
+				/* -> padding */
+				Values[6][Lane] = 1.f;
+				continue;
+			}
+
+			const FTransform& Transform = CCDIKLegChains[LegIndex].Chain[LinkIndex].Transform;
+			const FVector Location = Transform.GetLocation();
+			const FQuat Rotation = Transform.GetRotation();
+
+			Values[0][Lane] = Location.X;
+			Values[1][Lane] = Location.Y;
+			Values[2][Lane] = Location.Z;
+			Values[3][Lane] = Rotation.X;
+			Values[4][Lane] = Rotation.Y;
+			Values[5][Lane] = Rotation.Z;
+			Values[6][Lane] = Rotation.W;
+			Values[7][Lane] = CCDIKLegChains[LegIndex].Chain[LinkIndex].CurrentAngleDelta;
+
+			// the root and the tip are never rotated
+			bCanSolve[Lane] = LinkIndex > 0 && LinkIndex < NumLinks[Lane] - 1;
+			if (bCanSolve[Lane])
+			{
+				Values[8][Lane] = FeetRotationLimitsPerJoints[LegIndex].RotationLimits[LinkIndex];
+			}
+		}
+
+		FSPW_CCDIKLinkLanes& Link = CCDIKLinkLanes[Row];
+		Link.LocationX = VectorLoad(Values[0]);
+		Link.LocationY = VectorLoad(Values[1]);
+		Link.LocationZ = VectorLoad(Values[2]);
+		Link.RotationX = VectorLoad(Values[3]);
+		Link.RotationY = VectorLoad(Values[4]);
+		Link.RotationZ = VectorLoad(Values[5]);
+		Link.RotationW = VectorLoad(Values[6]);
+		Link.AngleDelta = VectorLoad(Values[7]);
+		Link.RotationLimit = VectorLoad(Values[8]);
+		Link.SolveMask = MakeMask(bCanSolve);
+	}
+
+	// targets & rotation limits
+	float TargetValues[3][SPW_CCDIK_LANES] = { { 0.f } };
+	bool bEnableRotationLimits[SPW_CCDIK_LANES] = { false };
+	bool bDisableRotationLimits[SPW_CCDIK_LANES] = { false };
+
+	for (int32 Lane = 0; Lane < NumLanes; Lane++)
+	{
+		const FVector& EffectorLocation = CCDIKLegChains[LaneLegIndices[Lane]].EffectorLocation;
+		TargetValues[0][Lane] = EffectorLocation.X;
+		TargetValues[1][Lane] = EffectorLocation.Y;
+		TargetValues[2][Lane] = EffectorLocation.Z;
+		bEnableRotationLimits[Lane] = Legs[LaneLegIndices[Lane]].bEnableRotationLimits;
+		bDisableRotationLimits[Lane] = !bEnableRotationLimits[Lane];
+	}
+
+	const VectorRegister TargetX = VectorLoad(TargetValues[0]);
+	const VectorRegister TargetY = VectorLoad(TargetValues[1]);
+	const VectorRegister TargetZ = VectorLoad(TargetValues[2]);
+	const VectorRegister RotationLimitsMask = MakeMask(bEnableRotationLimits);
+	const VectorRegister NoRotationLimitsMask = MakeMask(bDisableRotationLimits);
+	const VectorRegister SmallAngle = VectorSetFloat1(KINDA_SMALL_NUMBER);
+
+	// iterate
+	const int32 TipRow = MaxNumLinks - 1;
+	float LanePrecision[SPW_CCDIK_LANES] = { 0.f };
+	int32 LaneMaxIterations[SPW_CCDIK_LANES] = { 0 };
+	bool bIsLaneAlive[SPW_CCDIK_LANES] = { false };
+	bool bIsLaneUpdated[SPW_CCDIK_LANES] = { false };
+	int32 IterationCount[SPW_CCDIK_LANES] = { 0 };
+	float Distance[SPW_CCDIK_LANES] = { 0.f };
+
+	for (int32 Lane = 0; Lane < NumLanes; Lane++)
+	{
+		const FSPW_CCDIKLegChain& LegChain = CCDIKLegChains[LaneLegIndices[Lane]];
+		LanePrecision[Lane] = LegChain.Precision;
+		LaneMaxIterations[Lane] = LegChain.MaxIterations;
+		bIsLaneAlive[Lane] = true;
+		Distance[Lane] = FVector::Dist(LegChain.EffectorLocation, LegChain.Chain.Last().Transform.GetLocation());
+	}
+
+	while (true)
+	{
+		// lanes still iterating
+		bool bIsLaneActive[SPW_CCDIK_LANES] = { false };
+		bool bIsAnyLaneActive = false;
+
+		for (int32 Lane = 0; Lane < NumLanes; Lane++)
+		{
+			bIsLaneActive[Lane] = bIsLaneAlive[Lane] && (Distance[Lane] > LanePrecision[Lane]) && (IterationCount[Lane] < LaneMaxIterations[Lane]);
+			bIsAnyLaneActive |= bIsLaneActive[Lane];
+		}
+
+		if (!bIsAnyLaneActive)
+		{
+			break;
+		}
+
+		const VectorRegister ActiveMask = MakeMask(bIsLaneActive);
+		VectorRegister UpdatedMask = VectorZero();
+
+		// iterate over links
+		for (int32 Step = 1; Step < TipRow; Step++)
+		{
+			const int32 Row = bStartFromTail ? (TipRow - Step) : Step;
+			FSPW_CCDIKLinkLanes& CurrentLink = CCDIKLinkLanes[Row];
+			const FSPW_CCDIKLinkLanes& TipLink = CCDIKLinkLanes[TipRow];
+
+			VectorRegister Mask = VectorBitwiseAnd(ActiveMask, CurrentLink.SolveMask);
+			if (VectorMaskBits(Mask) == 0)
+			{
+				continue;
+			}
+
+			// to end & to target
+			VectorRegister ToEndX = VectorSubtract(TipLink.LocationX, CurrentLink.LocationX);
+			VectorRegister ToEndY = VectorSubtract(TipLink.LocationY, CurrentLink.LocationY);
+			VectorRegister ToEndZ = VectorSubtract(TipLink.LocationZ, CurrentLink.LocationZ);
+			VectorRegister ToTargetX = VectorSubtract(TargetX, CurrentLink.LocationX);
+			VectorRegister ToTargetY = VectorSubtract(TargetY, CurrentLink.LocationY);
+			VectorRegister ToTargetZ = VectorSubtract(TargetZ, CurrentLink.LocationZ);
+			Normalize(ToEndX, ToEndY, ToEndZ);
+			Normalize(ToTargetX, ToTargetY, ToTargetZ);
+
+			// angle, clamped to the rotation limit
+			const VectorRegister Dot = VectorMultiplyAdd(ToEndX, ToTargetX, VectorMultiplyAdd(ToEndY, ToTargetY, VectorMultiply(ToEndZ, ToTargetZ)));
+			VectorRegister Angle = VectorMin(VectorACos(VectorMax(VectorMin(Dot, VectorOne()), VectorNegate(VectorOne()))), CurrentLink.RotationLimit);
+
+			VectorRegister CanRotate = VectorCompareGT(Angle, SmallAngle);
+			CanRotate = VectorBitwiseAnd(CanRotate
+				, VectorBitwiseOr(VectorCompareGT(CurrentLink.RotationLimit, CurrentLink.AngleDelta), NoRotationLimitsMask));
+
+			// check rotation limit first, if fails, just abort
+			const VectorRegister IsOverLimit = VectorBitwiseAnd(RotationLimitsMask, VectorCompareGT(VectorAdd(CurrentLink.AngleDelta, Angle), CurrentLink.RotationLimit));
+			Angle = VectorSelect(IsOverLimit, VectorSubtract(CurrentLink.RotationLimit, CurrentLink.AngleDelta), Angle);
+			CanRotate = VectorSelect(IsOverLimit, VectorBitwiseAnd(CanRotate, VectorCompareGT(Angle, SmallAngle)), CanRotate);
+			Mask = VectorBitwiseAnd(Mask, CanRotate);
+
+			CurrentLink.AngleDelta = VectorSelect(VectorBitwiseAnd(Mask, RotationLimitsMask), VectorAdd(CurrentLink.AngleDelta, Angle), CurrentLink.AngleDelta);
+
+			// rotation axis
+			VectorRegister AxisX = VectorSubtract(VectorMultiply(ToEndY, ToTargetZ), VectorMultiply(ToEndZ, ToTargetY));
+			VectorRegister AxisY = VectorSubtract(VectorMultiply(ToEndZ, ToTargetX), VectorMultiply(ToEndX, ToTargetZ));
+			VectorRegister AxisZ = VectorSubtract(VectorMultiply(ToEndX, ToTargetY), VectorMultiply(ToEndY, ToTargetX));
+			const VectorRegister AxisSizeSquared = VectorMultiplyAdd(AxisX, AxisX, VectorMultiplyAdd(AxisY, AxisY, VectorMultiply(AxisZ, AxisZ)));
+			Mask = VectorBitwiseAnd(Mask, VectorCompareGT(AxisSizeSquared, VectorZero()));
+
+			if (VectorMaskBits(Mask) == 0)
+			{
+				continue;
+			}
+
+			Normalize(AxisX, AxisY, AxisZ);
+
+			// Delta Rotation is the rotation to target
+			VectorRegister HalfAngleSin;
+			VectorRegister HalfAngleCos;
+			const VectorRegister HalfAngle = VectorMultiply(Angle, VectorSetFloat1(.5f));
+			VectorSinCos(&HalfAngleSin, &HalfAngleCos, &HalfAngle);
+
+			const VectorRegister DeltaX = VectorMultiply(AxisX, HalfAngleSin);
+			const VectorRegister DeltaY = VectorMultiply(AxisY, HalfAngleSin);
+			const VectorRegister DeltaZ = VectorMultiply(AxisZ, HalfAngleSin);
+			const VectorRegister DeltaW = HalfAngleCos;
+
+			// rotate current link
+			RotateLink(CurrentLink, Mask, DeltaX, DeltaY, DeltaZ, DeltaW);
+
+			// now update all children around the current link
+			for (int32 ChildRow = Row + 1; ChildRow <= TipRow; ChildRow++)
+			{
+				FSPW_CCDIKLinkLanes& ChildLink = CCDIKLinkLanes[ChildRow];
+				RotateLinkLocation(ChildLink, Mask, CurrentLink.LocationX, CurrentLink.LocationY, CurrentLink.LocationZ, DeltaX, DeltaY, DeltaZ, DeltaW);
+				RotateLink(ChildLink, Mask, DeltaX, DeltaY, DeltaZ, DeltaW);
+			}
+
+			UpdatedMask = VectorBitwiseOr(UpdatedMask, Mask);
+		}
+
+		// distances
+		const FSPW_CCDIKLinkLanes& TipLink = CCDIKLinkLanes[TipRow];
+		const VectorRegister DistanceX = VectorSubtract(TipLink.LocationX, TargetX);
+		const VectorRegister DistanceY = VectorSubtract(TipLink.LocationY, TargetY);
+		const VectorRegister DistanceZ = VectorSubtract(TipLink.LocationZ, TargetZ);
+		VectorStore(VectorMultiplyAdd(DistanceX, DistanceX, VectorMultiplyAdd(DistanceY, DistanceY, VectorMultiply(DistanceZ, DistanceZ))), Distance);
+
+		const int32 UpdatedBits = VectorMaskBits(UpdatedMask);
+
+		for (int32 Lane = 0; Lane < NumLanes; Lane++)
+		{
+			Distance[Lane] = FMath::Sqrt(Distance[Lane]);
+
+			if (bIsLaneActive[Lane])
+			{
+				IterationCount[Lane]++;
+				bIsLaneUpdated[Lane] |= (UpdatedBits & (1 << Lane)) != 0;
+
+				// no more update in this iteration
+				if (!bIsLaneUpdated[Lane])
+				{
+					bIsLaneAlive[Lane] = false;
+				}
+			}
+		}
+	}
+
+	// unpack
+	for (int32 Row = 0; Row < MaxNumLinks; Row++)
+	{
+		const FSPW_CCDIKLinkLanes& Link = CCDIKLinkLanes[Row];
+		float Values[7][SPW_CCDIK_LANES];
+		VectorStore(Link.LocationX, Values[0]);
+		VectorStore(Link.LocationY, Values[1]);
+		VectorStore(Link.LocationZ, Values[2]);
+		VectorStore(Link.RotationX, Values[3]);
+		VectorStore(Link.RotationY, Values[4]);
+		VectorStore(Link.RotationZ, Values[5]);
+		VectorStore(Link.RotationW, Values[6]);
+
+		for (int32 Lane = 0; Lane < NumLanes; Lane++)
+		{
+			const int32 LinkIndex = Row - (MaxNumLinks - NumLinks[Lane]);
+
+			if (LinkIndex < 0 || !bIsLaneUpdated[Lane])
+			{
+				continue;
+			}
+
+			FTransform& Transform = CCDIKLegChains[LaneLegIndices[Lane]].Chain[LinkIndex].Transform;
+			Transform.SetLocation(FVector(Values[0][Lane], Values[1][Lane], Values[2][Lane]));
+			Transform.SetRotation(FQuat(Values[3][Lane], Values[4][Lane], Values[5][Lane], Values[6][Lane]));
+		}
+	}
+
+	for (int32 Lane = 0; Lane < NumLanes; Lane++)
+	{
+		FSPW_CCDIKLegChain& LegChain = CCDIKLegChains[LaneLegIndices[Lane]];
+		LegChain.bBoneLocationUpdated = bIsLaneUpdated[Lane];
+		LegChain.Iterations = IterationCount[Lane];
+		LegChain.ResidualError = Distance[Lane];
+
+		INC_DWORD_STAT_BY(STAT_SPW_CCDIKIterations, IterationCount[Lane]);
+	}
+}
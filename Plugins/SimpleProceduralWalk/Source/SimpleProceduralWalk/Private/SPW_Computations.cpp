@@ -6,13 +6,18 @@
 #include "SimpleProceduralWalkInterface.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "GameFramework/Actor.h"
+#include "Engine/World.h"
 #include "DrawDebugHelpers.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "Components/SkinnedMeshComponent.h"
 
 // constants
 static const float STEP_PERCENT_AT_BEGINNING = .15f;
 static const float STEP_PERCENT_AT_END = .85f;
 static const float SPEED_THRESHOLD_MIN = 2.f;
+static const float YAW_DELTA_REFERENCE_FPS = 60.f;
+static const float SLEEP_LOCATION_TOLERANCE = .1f;
+static const float SLEEP_ROTATION_TOLERANCE = 1.e-4f;
 
 
 /*
@@ -20,7 +25,7 @@ static const float SPEED_THRESHOLD_MIN = 2.f;
  */
 void FAnimNode_SPW::Initialize_Computations(const FAnimationInitializeContext& Context)
 {
-	if (!IsValid(OwnerPawn)) {
+	if (!OwnerPawn.IsValid()) {
 		return;
 	}
 
@@ -38,10 +43,21 @@ void FAnimNode_SPW::Initialize_Computations(const FAnimationInitializeContext& C
 	}
 	MeshAverageScale = Sum / Count;
 
+	// select evaluation policies & scale
+	SelectEvaluationPolicies();
+
 	// get half height
 	OwnerHalfHeight = ((OwnerPawn->GetActorLocation() - SkeletalMeshComponent->GetComponentLocation()) * OwnerPawn->GetActorUpVector()).Size();
 	UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("OwnerHalfHeight: %f"), OwnerHalfHeight);
 
+	// trace params (ignore self)
+	TraceQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(SimpleProceduralWalkTrace), bIsTraceComplex, OwnerPawn.Get());
+	TraceQueryParams.bReturnPhysicalMaterial = true;
+
+	// trace scratch
+	FootHoldHits.Reset();
+	FootHoldHits.Reserve(16);
+
 	// init legs
 	int32 FeetDataSize = Legs.Num();
 	LegsData.SetNum(FeetDataSize);
@@ -50,22 +66,26 @@ void FAnimNode_SPW::Initialize_Computations(const FAnimationInitializeContext& C
 	int32 FeetGroupsSize = LegGroups.Num();
 	GroupsData.SetNum(FeetGroupsSize);
 
+	// step events (a foot & a group event per leg & group, up and down)
+	StepEvents.Reset();
+	StepEvents.Reserve(2 * (FeetDataSize + FeetGroupsSize));
+
 	// init feet groups
 	for (int GroupIndex = 0; GroupIndex < LegGroups.Num(); GroupIndex++)
 	{
 		for (int LegIndex : LegGroups[GroupIndex].LegIndices)
 		{
-			LegsData[LegIndex].GroupIndex = GroupIndex;
+			LegsData.GroupIndices[LegIndex] = GroupIndex;
 		}
 	}
 
-	// solver
-	RadiusCheck = RadiusCheckMultiplier * FMath::Max(GetScaledStepDistanceForward(), GetScaledStepDistanceRight());
+	// solver (updated with the scalability)
+	RadiusCheck = GetRadiusCheckMultiplier() * FSimpleProceduralWalk_Scalability::GetRadiusCheckScale() * FMath::Max(GetScaledStepDistanceForward(), GetScaledStepDistanceRight());
 
 	// init feet data
 	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
 	{
-		FSimpleProceduralWalk_Leg Leg = Legs[LegIndex];
+		const FSimpleProceduralWalk_Leg& Leg = Legs[LegIndex];
 
 		UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Initializing %s bone data."), *Leg.TipBone.BoneName.ToString());
 
@@ -89,22 +109,22 @@ void FAnimNode_SPW::Initialize_Computations(const FAnimationInitializeContext& C
 		TipBoneRelLocation.Z = -OwnerHalfHeight;
 
 		// save feet length
-		LegsData[LegIndex].Length = (ParentBoneRelLocationWithOffsets.Z - TipBoneRelLocation.Z) * MeshScale.Z;
-		UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Bone %s length: %f"), *Leg.TipBone.BoneName.ToString(), LegsData[LegIndex].Length);
+		LegsData.Lengths[LegIndex] = (ParentBoneRelLocationWithOffsets.Z - TipBoneRelLocation.Z) * MeshScale.Z;
+		UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Bone %s length: %f"), *Leg.TipBone.BoneName.ToString(), LegsData.Lengths[LegIndex]);
 
 		// save relative position
-		LegsData[LegIndex].TipBoneOriginalRelLocation = TipBoneRelLocation;
+		LegsData.TipBoneOriginalRelLocations[LegIndex] = TipBoneRelLocation;
 
 		// save in world space
 		FVector TipBoneLocation = (FTransform(FRotator(0.f), TipBoneRelLocation, FVector(1.f)) * OwnerPawn->GetActorTransform()).GetLocation();
-		LegsData[LegIndex].FootTarget = TipBoneLocation;
-		LegsData[LegIndex].FootLocation = TipBoneLocation;
+		LegsData.FootTargets[LegIndex] = TipBoneLocation;
+		LegsData.FootLocations[LegIndex] = TipBoneLocation;
 
 		if (bDebug)
 		{
-			APawn* LOwnerPawn = OwnerPawn;
+			TWeakObjectPtr<APawn> LOwnerPawn = OwnerPawn;
 			AsyncTask(ENamedThreads::GameThread, [=]() {
-				UWorld* World = LOwnerPawn->GetWorld();
+				UWorld* World = LOwnerPawn.IsValid() ? LOwnerPawn->GetWorld() : nullptr;
 				DrawDebugSphere(World, TipBoneLocation, 12.f, 12, FColor::Purple, false, 5.f);
 			});
 		}
@@ -112,25 +132,25 @@ void FAnimNode_SPW::Initialize_Computations(const FAnimationInitializeContext& C
 		// Forward / Backward
 		if (FMath::IsNearlyEqual(ParentBoneRelLocationWithOffsets.X, 0.f, 0.001f))
 		{
-			LegsData[LegIndex].bIsForward = true;
-			LegsData[LegIndex].bIsBackwards = true;
+			LegsData.SetFlag(LegIndex, ESimpleProceduralWalk_LegFlags::Forward, true);
+			LegsData.SetFlag(LegIndex, ESimpleProceduralWalk_LegFlags::Backwards, true);
 		}
 		else
 		{
-			LegsData[LegIndex].bIsForward = ParentBoneRelLocationWithOffsets.X > 0;
-			LegsData[LegIndex].bIsBackwards = ParentBoneRelLocationWithOffsets.X < 0;
+			LegsData.SetFlag(LegIndex, ESimpleProceduralWalk_LegFlags::Forward, ParentBoneRelLocationWithOffsets.X > 0);
+			LegsData.SetFlag(LegIndex, ESimpleProceduralWalk_LegFlags::Backwards, ParentBoneRelLocationWithOffsets.X < 0);
 		}
 
 		// Right / Left
 		if (FMath::IsNearlyEqual(ParentBoneRelLocationWithOffsets.Y, 0.f, 0.001f))
 		{
-			LegsData[LegIndex].bIsRight = true;
-			LegsData[LegIndex].bIsLeft = true;
+			LegsData.SetFlag(LegIndex, ESimpleProceduralWalk_LegFlags::Right, true);
+			LegsData.SetFlag(LegIndex, ESimpleProceduralWalk_LegFlags::Left, true);
 		}
 		else
 		{
-			LegsData[LegIndex].bIsRight = ParentBoneRelLocationWithOffsets.Y > 0;
-			LegsData[LegIndex].bIsLeft = ParentBoneRelLocationWithOffsets.Y < 0;
+			LegsData.SetFlag(LegIndex, ESimpleProceduralWalk_LegFlags::Right, ParentBoneRelLocationWithOffsets.Y > 0);
+			LegsData.SetFlag(LegIndex, ESimpleProceduralWalk_LegFlags::Left, ParentBoneRelLocationWithOffsets.Y < 0);
 		}
 	}
 
@@ -147,31 +167,107 @@ void FAnimNode_SPW::Evaluate_Computations()
 {
 	if (bIsInitialized)
 	{
+		SCOPE_CYCLE_COUNTER(STAT_SPW_Computations);
+
+		// frozen gait (once faded out), also off screen (the tier is kept until rendered again)
+		if (CurrentQualityTier == ESimpleProceduralWalk_QualityTier::FROZEN && !FAnimWeight::IsRelevant(QualityTierBlendWeight))
+		{
+			return;
+		}
+
+		// asleep, only check for movement
+		if (bIsAsleep)
+		{
+			if (!ShouldWakeUp())
+			{
+				return;
+			}
+			UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Walker woke up."));
+			WakeUp();
+		}
+
+		// pose copied from a template walker
+		if (bIsPoseClone)
+		{
+			ComputeFromTemplate();
+			return;
+		}
+
 		// common
 		UpdatePawnVariables();
-		SetSupportCompDeltas();
 
-		// walk
-		SetFeetTargetLocations();
+		// sub-steps (long updates are split, the update delta is restored at the end)
+		const float UpdateDeltaSeconds = WorldDeltaSeconds;
+		const int32 NumSubsteps = GetNumSubsteps();
 
-		if (bIsFalling)
+		// body only (and frozen, while fading out), feet follow the body
+		if ((CurrentQualityTier == ESimpleProceduralWalk_QualityTier::BODY_ONLY && !bIsOffScreen) || CurrentQualityTier == ESimpleProceduralWalk_QualityTier::FROZEN)
 		{
-			// falling -> compute only feet locations
-			ComputeFeet();
+			WorldDeltaSeconds = UpdateDeltaSeconds / NumSubsteps;
+			for (int32 SubstepIndex = 0; SubstepIndex < NumSubsteps; SubstepIndex++)
+			{
+				ComputeFeetAtRest();
+				ComputeBodyTransform();
+			}
+			WorldDeltaSeconds = UpdateDeltaSeconds;
+			return;
+		}
+
+		// walk
+		if (bIsOffScreen)
+		{
+			// no traces
+			SetOffScreenFeetTargetLocations();
 		}
 		else
 		{
-			// on ground
-			SetCurrentGroupUnplanted();
-			ComputeFeet();
-			SetGroupsPlanted();
+			SetSupportCompDeltas();
+			SetFeetTargetLocations();
+		}
+
+		// support movement is spread over the sub-steps
+		if (NumSubsteps > 1)
+		{
+			for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
+			{
+				LegsData.SupportCompDeltas[LegIndex] /= NumSubsteps;
+			}
+		}
+
+		WorldDeltaSeconds = UpdateDeltaSeconds / NumSubsteps;
+		for (int32 SubstepIndex = 0; SubstepIndex < NumSubsteps; SubstepIndex++)
+		{
+			if (bIsFalling)
+			{
+				// falling -> compute only feet locations
+				ComputeFeet();
+			}
+			else
+			{
+				// on ground
+				SetCurrentGroupUnplanted();
+				ComputeFeet();
+				SetGroupsPlanted();
+			}
+
+			// body
+			ComputeBodyTransform();
+		}
+		WorldDeltaSeconds = UpdateDeltaSeconds;
+
+		// share with distant walkers
+		if (bEnablePoseSharing)
+		{
+			PublishPose();
 		}
 
-		// body
-		ComputeBodyTransform();
+		// go to sleep when still
+		UpdateSleep();
 
 		// debug
+#if ENABLE_DRAW_DEBUG
 		DebugShow();
+#endif
 	}
 }
 
@@ -201,8 +297,9 @@ void FAnimNode_SPW::UpdatePawnVariables()
 		, 0.f, 180.f
 		, 1.f, -1.f);
 
-	// Rotation
+	// Rotation (per reference frame, so that it does not depend on the update rate)
 	YawDelta = UKismetMathLibrary::NormalizedDeltaRotator(OwnerPawn->GetActorRotation(), PreviousRotation).Yaw;
+	YawDelta = WorldDeltaSeconds > KINDA_SMALL_NUMBER ? YawDelta / (WorldDeltaSeconds * YAW_DELTA_REFERENCE_FPS) : 0.f;
 	PreviousRotation = OwnerPawn->GetActorRotation();
 
 	// Current step length
@@ -229,9 +326,12 @@ void FAnimNode_SPW::UpdatePawnVariables()
 		CurrentStepDuration = GetScaledMinStepDuration();
 	}
 
-	// Acceleration
-	ForwardAcceleration = ((ForwardPercent * Speed) - (PreviousForwardPercent * PreviousSpeed)) / WorldDeltaSeconds;
-	RightAcceleration = ((RightPercent * Speed) - (PreviousRightPercent * PreviousSpeed)) / WorldDeltaSeconds;
+	// Acceleration (kept when there is no elapsed time)
+	if (WorldDeltaSeconds > KINDA_SMALL_NUMBER)
+	{
+		ForwardAcceleration = ((ForwardPercent * Speed) - (PreviousForwardPercent * PreviousSpeed)) / WorldDeltaSeconds;
+		RightAcceleration = ((RightPercent * Speed) - (PreviousRightPercent * PreviousSpeed)) / WorldDeltaSeconds;
+	}
 	PreviousSpeed = Speed;
 	PreviousForwardPercent = ForwardPercent;
 	PreviousRightPercent = RightPercent;
@@ -242,38 +342,197 @@ void FAnimNode_SPW::UpdatePawnVariables()
  */
 void FAnimNode_SPW::SetSupportCompDeltas()
 {
+	// support transforms of this frame, shared by the legs standing on the same component & bone
+	struct FSupportTransformCacheEntry
+	{
+		const UPrimitiveComponent* Component;
+		FName BoneName;
+		FTransform Transform;
+	};
+	TArray<FSupportTransformCacheEntry, TInlineAllocator<SPW_INLINE_LEGS>> SupportTransformCache;
+
 	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
 	{
-		// is the pawn standing on a component?
-		if (IsValid(LegsData[LegIndex].SupportComp))
+		// static supports never move
+		if (LegsData.Supports[LegIndex].bIsStatic)
 		{
-			// current
-			FName BoneName = LegsData[LegIndex].LastHit.BoneName;
-			FTransform SupportCompCurrentTransform = LegsData[LegIndex].SupportComp->GetSocketTransform(BoneName);
+			LegsData.SupportCompDeltas[LegIndex] = FVector(0.f);
+			continue;
+		}
+
+		// is the pawn standing on a component? (resolved once per frame)
+		UPrimitiveComponent* SupportComp = LegsData.Supports[LegIndex].Component.Get();
+		if (SupportComp != nullptr && LegsData.Supports[LegIndex].HasTransform())
+		{
+			// current (looked up once per component & bone)
+			const FName BoneName = LegsData.Supports[LegIndex].BoneName;
+			const FSupportTransformCacheEntry* CacheEntry = SupportTransformCache.FindByPredicate([SupportComp, BoneName](const FSupportTransformCacheEntry& Entry) {
+				return Entry.Component == SupportComp && Entry.BoneName == BoneName;
+			});
+			if (CacheEntry == nullptr)
+			{
+				CacheEntry = &SupportTransformCache.Add_GetRef({ SupportComp, BoneName, LegsData.Supports[LegIndex].GetTransform(SupportComp) });
+			}
+			const FTransform& SupportCompCurrentTransform = CacheEntry->Transform;
 
 			// sanity check
 			if (SupportCompCurrentTransform.IsRotationNormalized())
 			{
 				// compute world locations
-				FVector PreviousLocation = (FTransform(FRotator(0.f), LegsData[LegIndex].RelLocationToSupportComp, FVector(1.f)) * LegsData[LegIndex].SupportCompPreviousTransform).GetLocation();
-				FVector NewLocation = (FTransform(FRotator(0.f), LegsData[LegIndex].RelLocationToSupportComp, FVector(1.f)) * SupportCompCurrentTransform).GetLocation();
+				FVector PreviousLocation = (FTransform(FRotator(0.f), LegsData.Supports[LegIndex].RelLocation, FVector(1.f)) * LegsData.Supports[LegIndex].PreviousTransform).GetLocation();
+				FVector NewLocation = (FTransform(FRotator(0.f), LegsData.Supports[LegIndex].RelLocation, FVector(1.f)) * SupportCompCurrentTransform).GetLocation();
 
 				// save delta
-				LegsData[LegIndex].SupportCompDelta = NewLocation - PreviousLocation;
+				LegsData.SupportCompDeltas[LegIndex] = NewLocation - PreviousLocation;
 
 				// save previous transform
-				LegsData[LegIndex].SupportCompPreviousTransform = SupportCompCurrentTransform;
+				LegsData.Supports[LegIndex].PreviousTransform = SupportCompCurrentTransform;
 			}
 			else
 			{
 				// set to 0
-				LegsData[LegIndex].SupportCompDelta = FVector(0.f);
+				LegsData.SupportCompDeltas[LegIndex] = FVector(0.f);
 			}
 		}
 		else
 		{
 			// set to 0
-			LegsData[LegIndex].SupportCompDelta = FVector(0.f);
+			LegsData.SupportCompDeltas[LegIndex] = FVector(0.f);
+		}
+	}
+}
+
+int32 FAnimNode_SPW::GetNumSubsteps() const
+{
+	if (MaxSubstepDeltaTime <= 0.f)
+	{
+		return 1;
+	}
+
+	return FMath::Clamp(FMath::CeilToInt(WorldDeltaSeconds / MaxSubstepDeltaTime), 1, FMath::Max(MaxSubsteps, 1));
+}
+
+/*
+ * -> SLEEP
+ */
+void FAnimNode_SPW::UpdateSleep()
+{
+	if (!bEnableSleep || bKeepAwake || bIsOffScreen)
+	{
+		StillTime = 0.f;
+		return;
+	}
+
+	// pawn still
+	bool bIsStill = Speed == 0.f && FMath::Abs(YawDelta) <= SPEED_THRESHOLD_MIN && !bIsFalling;
+
+	// all groups planted
+	for (const FSimpleProceduralWalk_LegGroupData& GroupData : GroupsData)
+	{
+		bIsStill = bIsStill && !GroupData.bIsUnplanted;
+	}
+
+	// no support moving
+	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
+	{
+		bIsStill = bIsStill && LegsData.SupportCompDeltas[LegIndex].IsNearlyZero();
+	}
+
+	StillTime = bIsStill ? StillTime + WorldDeltaSeconds : 0.f;
+
+	if (StillTime >= SleepDelay)
+	{
+		UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Walker went to sleep."));
+		bIsAsleep = true;
+		SleepActorLocation = OwnerPawn->GetActorLocation();
+		SleepActorRotation = OwnerPawn->GetActorQuat();
+	}
+}
+
+bool FAnimNode_SPW::ShouldWakeUp()
+{
+	if (!bEnableSleep || bKeepAwake || bIsOffScreen)
+	{
+		return true;
+	}
+
+	// incoming pose changed (for instance an idle animation), feet & body are computed again
+	if (bIsSleepInputPoseChanged)
+	{
+		return true;
+	}
+
+	// pawn moved (or was moved)
+	if (OwnerPawn->GetVelocity().Size() > SPEED_THRESHOLD_MIN
+		|| !OwnerPawn->GetActorLocation().Equals(SleepActorLocation, SLEEP_LOCATION_TOLERANCE)
+		|| !OwnerPawn->GetActorQuat().Equals(SleepActorRotation, SLEEP_ROTATION_TOLERANCE))
+	{
+		return true;
+	}
+
+	// a support moved
+	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
+	{
+		const FSimpleProceduralWalk_LegSupport& Support = LegsData.Supports[LegIndex];
+		UPrimitiveComponent* SupportComp = Support.Component.Get();
+		if (Support.bIsStatic || SupportComp == nullptr || !Support.HasTransform())
+		{
+			continue;
+		}
+
+		const FTransform SupportTransform = Support.GetTransform(SupportComp);
+		if (!SupportTransform.GetLocation().Equals(Support.PreviousTransform.GetLocation(), SLEEP_LOCATION_TOLERANCE)
+			|| !SupportTransform.GetRotation().Equals(Support.PreviousTransform.GetRotation(), SLEEP_ROTATION_TOLERANCE))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FAnimNode_SPW::WakeUp()
+{
+	bIsAsleep = false;
+	bIsSleepInputPoseChanged = false;
+	StillTime = 0.f;
+}
+
+void FAnimNode_SPW::Evaluate_SleepInputPose(FComponentSpacePoseContext& Output)
+{
+	const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
+	const int32 NumTransforms = Legs.Num() + 1;
+
+	if (SleepInputTransforms.Num() != NumTransforms)
+	{
+		SleepInputTransforms.SetNum(NumTransforms);
+	}
+
+	for (int32 TransformIndex = 0; TransformIndex < NumTransforms; TransformIndex++)
+	{
+		// body, then tip bones (bones removed by LOD are skipped)
+		const FCompactPoseBoneIndex BoneIndex = TransformIndex == 0
+			? BodyBone.GetCompactPoseIndex(BoneContainer)
+			: TipBones[TransformIndex - 1].GetCompactPoseIndex(BoneContainer);
+		if (BoneIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		const FTransform& InputTransform = Output.Pose.GetComponentSpaceTransform(BoneIndex);
+
+		if (bIsAsleep)
+		{
+			/* -> compare with the pose the walker went to sleep on */
+			if (!InputTransform.GetLocation().Equals(SleepInputTransforms[TransformIndex].GetLocation(), SLEEP_LOCATION_TOLERANCE)
+				|| !InputTransform.GetRotation().Equals(SleepInputTransforms[TransformIndex].GetRotation(), SLEEP_ROTATION_TOLERANCE))
+			{
+				bIsSleepInputPoseChanged = true;
+			}
+		}
+		else
+		{
+			SleepInputTransforms[TransformIndex] = InputTransform;
 		}
 	}
 }
@@ -283,16 +542,49 @@ void FAnimNode_SPW::SetSupportCompDeltas()
  */
 void FAnimNode_SPW::SetFeetTargetLocations()
 {
+	SCOPE_CYCLE_COUNTER(STAT_SPW_FeetTargets);
+
+	(this->*SetFeetTargetLocationsFunction)();
+}
+
+void FAnimNode_SPW::SetOffScreenFeetTargetLocations()
+{
+	// rest locations moved by the step (as the start locations of the traces)
+	const FVector StepOffset = FVector(GetScaledStepDistanceForward() * ForwardPercent, GetScaledStepDistanceRight() * RightPercent, 0.f);
+
+	TSimpleProceduralWalk_LegArray<FVector> FeetRelTargets;
+	FeetRelTargets.SetNumUninitialized(LegsData.Num());
+	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
+	{
+		FeetRelTargets[LegIndex] = LegsData.TipBoneOriginalRelLocations[LegIndex] + StepOffset;
+		LegsData.FootTargetRotations[LegIndex] = FQuat::Identity;
+		LegsData.SupportCompDeltas[LegIndex] = FVector(0.f);
+	}
+
+	SimpleProceduralWalk_SpaceConversion::TransformLocations(OwnerPawn->GetActorTransform(), FeetRelTargets.GetData(), LegsData.FootTargets.GetData(), LegsData.Num());
+}
+
+template<ESimpleProceduralWalk_SolverType InSolverType, bool bInDebug>
+void FAnimNode_SPW::SetFeetTargetLocationsWithPolicy()
+{
+	// legs are spread over the trace interval (1 unless reduced)
+	TraceFrame++;
+
 	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
 	{
-		SetFootTargetLocation(LegIndex);
+		if (TraceInterval > 1 && (TraceFrame + LegIndex) % TraceInterval != 0)
+		{
+			continue;
+		}
+		SetFootTargetLocation<InSolverType, bInDebug>(LegIndex);
 	}
 }
 
+template<ESimpleProceduralWalk_SolverType InSolverType, bool bInDebug>
 void FAnimNode_SPW::SetFootTargetLocation(int32 LegIndex)
 {
 	// get foot data
-	FSimpleProceduralWalk_Leg Leg = Legs[LegIndex];
+	const FSimpleProceduralWalk_Leg& Leg = Legs[LegIndex];
 
 	// Parent Bone Location
 	FVector ParentBoneLocation = SkeletalMeshComponent->GetSocketLocation(Leg.ParentBone.BoneName);
@@ -313,33 +605,25 @@ void FAnimNode_SPW::SetFootTargetLocation(int32 LegIndex)
 	bool bIsFootHoldHit;
 	FHitResult Hit;
 
-	// prepare ignore actors
-	TArray<AActor*> ActorsToIgnore;
-	ActorsToIgnore.Add(OwnerPawn);
-
 	// line hit
-	bIsHit = UKismetSystemLibrary::LineTraceSingle(WorldContext
+	bIsHit = WorldContext->LineTraceSingleByChannel(Hit
 		, StartLocation
 		, EndLocation
-		, TraceChannel
-		, bTraceComplex
-		, ActorsToIgnore
-		, EDrawDebugTrace::None
-		, Hit
-		, true
+		, UEngineTypes::ConvertToCollisionChannel(GetTraceChannel())
+		, TraceQueryParams
 	);
 
-	if (SolverType == ESimpleProceduralWalk_SolverType::BASIC)
+	if (InSolverType == ESimpleProceduralWalk_SolverType::BASIC)
 	{
 		// ---------- \/ BASIC ----------
-		if (bDebug)
+		if (bInDebug)
 		{
-			APawn* LOwnerPawn = OwnerPawn;
+			TWeakObjectPtr<APawn> LOwnerPawn = OwnerPawn;
 			FTransform DebugTransform = FTransform(OwnerPawn->GetActorRotation(), Hit.ImpactPoint, FVector(1.f));
 
 			// line
 			AsyncTask(ENamedThreads::GameThread, [=]() {
-				UWorld* World = LOwnerPawn->GetWorld();
+				UWorld* World = LOwnerPawn.IsValid() ? LOwnerPawn->GetWorld() : nullptr;
 				// draw line
 				DrawDebugLine(World, StartLocation, EndLocation, (bIsHit ? FColor::Green : FColor::Red));
 				// hit point
@@ -359,23 +643,21 @@ void FAnimNode_SPW::SetFootTargetLocation(int32 LegIndex)
 		float ZDistanceToLineHit = (StartLocationWithoutZOffset - Hit.ImpactPoint).Size();
 
 		// should we also foot hold hit?
-		bool bIsTooDistant = ZDistanceToLineHit > (LegsData[LegIndex].Length * DistanceCheckMultiplier);
+		bool bIsTooDistant = ZDistanceToLineHit > (LegsData.Lengths[LegIndex] * GetDistanceCheckMultiplier());
 
 		if (!bIsHit || bIsTooDistant)
 		{
 			/* -> no hit or hit too distant -> do sphere trace */
-			TArray<FHitResult> FootHoldHits;
+			FootHoldHits.Reset();
 
-			bIsFootHoldHit = UKismetSystemLibrary::SphereTraceMulti(WorldContext
+			bIsFootHoldHit = WorldContext->SweepMultiByChannel(FootHoldHits
 				, StartLocation
 				, EndLocation
-				, RadiusCheck
-				, TraceChannel
-				, bTraceComplex
-				, ActorsToIgnore
-				, EDrawDebugTrace::None
-				, FootHoldHits
-				, true);
+				, FQuat::Identity
+				, UEngineTypes::ConvertToCollisionChannel(GetTraceChannel())
+				, FCollisionShape::MakeSphere(RadiusCheck)
+				, TraceQueryParams
+			);
 
 			if (FootHoldHits.Num() > 0)
 			{
@@ -386,7 +668,7 @@ void FAnimNode_SPW::SetFootTargetLocation(int32 LegIndex)
 				//   . distance < line trace distance
 				//   . hit normals not perpendicular to pawn's up vector (i.e. walls are less appealing)
 				float MinZ = (GetScaledTraceLength() + GetScaledTraceZOffset()) * 2;
-				for (FHitResult FootHoldHit : FootHoldHits)
+				for (const FHitResult& FootHoldHit : FootHoldHits)
 				{
 					// compute distance
 					float ZDistanceToFootHoldHit = (StartLocationWithoutZOffset - FootHoldHit.ImpactPoint).Size();
@@ -434,9 +716,9 @@ void FAnimNode_SPW::SetFootTargetLocation(int32 LegIndex)
 			bIsUsingBasic = true;
 		}
 
-		if (bDebug)
+		if (bInDebug)
 		{
-			APawn* LOwnerPawn = OwnerPawn;
+			TWeakObjectPtr<APawn> LOwnerPawn = OwnerPawn;
 
 			FVector DebugCapsuleCenter = FMath::Lerp(StartLocation, EndLocation, .5f);
 			float DebugCapsuleHalfHeight = FVector::Distance(StartLocation, EndLocation) / 2;
@@ -448,7 +730,7 @@ void FAnimNode_SPW::SetFootTargetLocation(int32 LegIndex)
 			float Radius = RadiusCheck;
 
 			AsyncTask(ENamedThreads::GameThread, [=]() {
-				UWorld* World = LOwnerPawn->GetWorld();
+				UWorld* World = LOwnerPawn.IsValid() ? LOwnerPawn->GetWorld() : nullptr;
 
 				// line
 				DrawDebugLine(World, StartLocation, EndLocation, bIsUsingBasic ? (bIsHit ? FColor::Green : FColor::Red) : FColor::Silver);
@@ -465,7 +747,7 @@ void FAnimNode_SPW::SetFootTargetLocation(int32 LegIndex)
 	}
 
 	// init rotation
-	FRotator TargetFootRotationCS;
+	FQuat TargetFootRotationCS;
 
 	// result
 	if (bIsHit)
@@ -483,14 +765,14 @@ void FAnimNode_SPW::SetFootTargetLocation(int32 LegIndex)
 			|| (IsLegUnplanted(LegIndex) && (GetLegStepPercent(LegIndex) < STEP_PERCENT_AT_BEGINNING || GetLegStepPercent(LegIndex) > STEP_PERCENT_AT_END))
 			)
 		{
-			// get hit rotation from normals
-			FRotator TargetFootRotationWorld = UKismetMathLibrary::MakeRotFromZX(Hit.ImpactNormal, SkeletalMeshComponent->GetForwardVector());
-			TargetFootRotationCS = UKismetMathLibrary::InverseTransformRotation(SkeletalMeshComponent->GetComponentTransform(), TargetFootRotationWorld);
+			// get hit rotation from normals (surface aligned frame)
+			const FQuat TargetFootRotationWorld = FRotationMatrix::MakeFromZX(Hit.ImpactNormal, SkeletalMeshComponent->GetForwardVector()).ToQuat();
+			TargetFootRotationCS = SkeletalMeshComponent->GetComponentQuat().Inverse() * TargetFootRotationWorld;
 		}
 		else
 		{
 			// no added rotation
-			TargetFootRotationCS = FRotator(0.f, 0.f, 0.f);
+			TargetFootRotationCS = FQuat::Identity;
 		}
 
 		// set target
@@ -499,23 +781,23 @@ void FAnimNode_SPW::SetFootTargetLocation(int32 LegIndex)
 		if (IsLegUnplanted(LegIndex))
 		{
 			/* -> leg is un planted */
-			if (GetLegStepPercent(LegIndex) < FixFeetTargetsAfterPercent)
+			if (GetLegStepPercent(LegIndex) < GetFixFeetTargetsAfterPercent())
 			{
 				/* -> not too far along the step, update target */
-				LegsData[LegIndex].FootTarget = FootTarget;
+				LegsData.FootTargets[LegIndex] = FootTarget;
 			}
 			else
 			{
 				/* -> too far along the step, do not update target to avoid jiggling */
 				// add moving platform to target
-				LegsData[LegIndex].FootTarget += LegsData[LegIndex].SupportCompDelta;
+				LegsData.FootTargets[LegIndex] += LegsData.SupportCompDeltas[LegIndex];
 			}
 		}
 		else
 		{
 			/* -> leg is planted */
 			// update target
-			LegsData[LegIndex].FootTarget = FootTarget;
+			LegsData.FootTargets[LegIndex] = FootTarget;
 		}
 	}
 	else
@@ -523,21 +805,64 @@ void FAnimNode_SPW::SetFootTargetLocation(int32 LegIndex)
 		UE_LOG(LogSimpleProceduralWalk, VeryVerbose, TEXT("NO HIT for %s"), *Leg.ParentBone.BoneName.ToString());
 
 		// set target to original foot location in world space
-		FVector FootTarget = (FTransform(FRotator(0.f), LegsData[LegIndex].TipBoneOriginalRelLocation, FVector(1.f)) * OwnerPawn->GetActorTransform()).GetLocation();
-		LegsData[LegIndex].FootTarget = FootTarget;
+		FVector FootTarget = (FTransform(FRotator(0.f), LegsData.TipBoneOriginalRelLocations[LegIndex], FVector(1.f)) * OwnerPawn->GetActorTransform()).GetLocation();
+		LegsData.FootTargets[LegIndex] = FootTarget;
 
 		// no rotation
-		TargetFootRotationCS = FRotator(0.f, 0.f, 0.f);
+		TargetFootRotationCS = FQuat::Identity;
 	}
 
 	// interp & save
-	LegsData[LegIndex].FootTargetRotation = FMath::RInterpTo(LegsData[LegIndex].FootTargetRotation, TargetFootRotationCS, WorldDeltaSeconds, FeetTipBonesRotationInterpSpeed);
+	LegsData.FootTargetRotations[LegIndex] = FMath::QInterpTo(LegsData.FootTargetRotations[LegIndex], TargetFootRotationCS, WorldDeltaSeconds, GetFeetTipBonesRotationInterpSpeed());
 
 	// set IK enabled
-	LegsData[LegIndex].bEnableIK = bIsHit;
+	LegsData.SetFlag(LegIndex, ESimpleProceduralWalk_LegFlags::EnableIK, bIsHit);
 
 	// save last hit
-	LegsData[LegIndex].LastHit = Hit;
+	LegsData.LastHits[LegIndex].SetFromHitResult(Hit);
+}
+
+// the evaluation policies are selected once, so that the per-leg loops do not branch on settings
+void FAnimNode_SPW::SelectEvaluationPolicies()
+{
+	// [solver type][debug]
+	static const FSetFeetTargetLocationsFunction SetFeetTargetLocationsFunctions[2][2] = {
+		{
+			&FAnimNode_SPW::SetFeetTargetLocationsWithPolicy<ESimpleProceduralWalk_SolverType::BASIC, false>,
+#if ENABLE_DRAW_DEBUG
+			&FAnimNode_SPW::SetFeetTargetLocationsWithPolicy<ESimpleProceduralWalk_SolverType::BASIC, true>,
+#else
+			&FAnimNode_SPW::SetFeetTargetLocationsWithPolicy<ESimpleProceduralWalk_SolverType::BASIC, false>,
+#endif
+		},
+		{
+			&FAnimNode_SPW::SetFeetTargetLocationsWithPolicy<ESimpleProceduralWalk_SolverType::ADVANCED, false>,
+#if ENABLE_DRAW_DEBUG
+			&FAnimNode_SPW::SetFeetTargetLocationsWithPolicy<ESimpleProceduralWalk_SolverType::ADVANCED, true>,
+#else
+			&FAnimNode_SPW::SetFeetTargetLocationsWithPolicy<ESimpleProceduralWalk_SolverType::ADVANCED, false>,
+#endif
+		},
+	};
+
+	// debug drawing is stripped from builds without debug draw support
+#if ENABLE_DRAW_DEBUG
+	bIsDebugDrawEnabled = bDebug && bIsPlaying;
+#else
+	bIsDebugDrawEnabled = false;
+#endif
+
+	// the reduced quality tier uses the BASIC solver, and traces less often (as may the governor)
+	const FSimpleProceduralWalk_Governor& Governor = FSimpleProceduralWalk_Governor::Get();
+	const bool bIsReduced = CurrentQualityTier != ESimpleProceduralWalk_QualityTier::FULL;
+	const bool bIsBasic = bIsReduced || Governor.IsBasicSolverForced() || bIsBasicSolverForced;
+	const int32 SolverIndex = GetSolverType() == ESimpleProceduralWalk_SolverType::ADVANCED && !bIsBasic ? 1 : 0;
+	SetFeetTargetLocationsFunction = SetFeetTargetLocationsFunctions[SolverIndex][bIsDebugDrawEnabled ? 1 : 0];
+	TraceInterval = FMath::Max(bIsReduced ? ReducedTraceInterval : 1, Governor.GetMinTraceInterval());
+
+	// scale
+	SettingsScale = bScaleWithSkeletalMesh ? MeshScale : FVector(1.f);
+	SettingsAverageScale = bScaleWithSkeletalMesh ? MeshAverageScale : 1.f;
 }
 
 /*
@@ -555,7 +880,7 @@ void FAnimNode_SPW::SetCurrentGroupUnplanted()
 	bool bIsAtLeastOneFootFarEnough = false;
 	for (int LegIndex : LegGroups[CurrentGroupIndex].LegIndices)
 	{
-		if (FVector::Dist(LegsData[LegIndex].FootLocation, LegsData[LegIndex].FootTarget) >= GetAdaptedMinDistanceToUnplant(LegIndex))
+		if (FVector::Dist(LegsData.FootLocations[LegIndex], LegsData.FootTargets[LegIndex]) >= GetAdaptedMinDistanceToUnplant(LegIndex))
 		{
 			bIsAtLeastOneFootFarEnough = true;
 			break;
@@ -596,7 +921,7 @@ void FAnimNode_SPW::SetCurrentGroupUnplanted()
 	for (int LegIndex : LegGroups[CurrentGroupIndex].LegIndices)
 	{
 		// set feet unplant locations
-		LegsData[LegIndex].FootUnplantLocation = LegsData[LegIndex].FootLocation;
+		LegsData.FootUnplantLocations[LegIndex] = LegsData.FootLocations[LegIndex];
 	}
 
 	// call interface events
@@ -618,7 +943,7 @@ void FAnimNode_SPW::ComputeFeet()
 			// update locations for all feet in group
 			for (int LegIndex : LegGroups[GroupIndex].LegIndices)
 			{
-				LegsData[LegIndex].FootLocation = FMath::VInterpTo(LegsData[LegIndex].FootLocation, LegsData[LegIndex].FootTarget, WorldDeltaSeconds, FeetInAirInterSpeed);
+				LegsData.FootLocations[LegIndex] = FMath::VInterpTo(LegsData.FootLocations[LegIndex], LegsData.FootTargets[LegIndex], WorldDeltaSeconds, GetFeetInAirInterSpeed());
 			}
 		}
 		else
@@ -636,14 +961,14 @@ void FAnimNode_SPW::ComputeFeet()
 				// animate all feet in group
 				for (int LegIndex : LegGroups[GroupIndex].LegIndices)
 				{
-					LegsData[LegIndex].FootLocation =
+					LegsData.FootLocations[LegIndex] =
 						// interp location vector
-						FMath::Lerp(LegsData[LegIndex].FootUnplantLocation, LegsData[LegIndex].FootTarget, RelativeDistance)
+						FMath::Lerp(LegsData.FootUnplantLocations[LegIndex], LegsData.FootTargets[LegIndex], RelativeDistance)
 						// add height
 						+ RelativeZ * OwnerPawn->GetActorUpVector();
 
 					// add moving platform delta
-					LegsData[LegIndex].FootUnplantLocation += LegsData[LegIndex].SupportCompDelta;
+					LegsData.FootUnplantLocations[LegIndex] += LegsData.SupportCompDeltas[LegIndex];
 				}
 			}
 			else
@@ -654,14 +979,14 @@ void FAnimNode_SPW::ComputeFeet()
 					// check if too far
 					float FootDistanceFromLocation = FVector::Dist(
 						// foot location
-						(LegsData[LegIndex].FootLocation + LegsData[LegIndex].SupportCompDelta)
+						(LegsData.FootLocations[LegIndex] + LegsData.SupportCompDeltas[LegIndex])
 						// actual socket
 						, SkeletalMeshComponent->GetSocketLocation(Legs[LegIndex].TipBone.BoneName));
 
-					if (FootDistanceFromLocation <= (GetAdaptedMinDistanceToUnplant(LegIndex) * DistanceCheckMultiplier))
+					if (FootDistanceFromLocation <= (GetAdaptedMinDistanceToUnplant(LegIndex) * GetDistanceCheckMultiplier()))
 					{
 						/* -> foot not too far, add support movement */
-						LegsData[LegIndex].FootLocation += LegsData[LegIndex].SupportCompDelta;
+						LegsData.FootLocations[LegIndex] += LegsData.SupportCompDeltas[LegIndex];
 					}
 				}
 			}
@@ -684,11 +1009,19 @@ void FAnimNode_SPW::SetGroupsPlanted()
 				/* group has reached end of step -> PLANT GROUP! */
 				UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Planting group with index %d"), GroupIndex);
 
-				// set original feet components
-				for (int LegIndex : LegGroups[GroupIndex].LegIndices)
+				// set original feet components (last hits are not updated off screen)
+				if (!bIsOffScreen)
 				{
-					// save support comp & data
-					SetSupportComponentData(LegIndex, LegsData[LegIndex].FootLocation);
+					for (int LegIndex : LegGroups[GroupIndex].LegIndices)
+					{
+						// save support comp & data
+						SetSupportComponentData(LegIndex, LegsData.FootLocations[LegIndex]);
+					}
+
+					if (bTickAfterSkinnedSupports)
+					{
+						UpdateSupportTickPrerequisites();
+					}
 				}
 
 				// set group as planted
@@ -708,22 +1041,28 @@ void FAnimNode_SPW::ComputeBodyTransform()
 	FVector AverageFeetTargetsRight;
 	FVector AverageFeetTargetsLeft;
 
-	GetAverageFeetTargets(&AverageFeetTargetsForward
+	// local targets (converted once, for the averages & the feet plane)
+	TSimpleProceduralWalk_LegArray<FVector> FeetRelTargets;
+	FeetRelTargets.SetNumUninitialized(LegsData.Num());
+	SimpleProceduralWalk_SpaceConversion::InverseTransformLocations(OwnerPawn->GetActorTransform(), LegsData.FootTargets.GetData(), FeetRelTargets.GetData(), LegsData.Num());
+
+	GetAverageFeetTargets(FeetRelTargets
+		, &AverageFeetTargetsForward
 		, &AverageFeetTargetsBackwards
 		, &AverageFeetTargetsRight
 		, &AverageFeetTargetsLeft);
 
 	// debug
-	if (bDebug && bIsPlaying)
+	if (bIsDebugDrawEnabled)
 	{
-		APawn* LOwnerPawn = OwnerPawn;
+		TWeakObjectPtr<APawn> LOwnerPawn = OwnerPawn;
 		FVector AverageFeetTargetsForwardWorld = (FTransform(FRotator(0.f), AverageFeetTargetsForward, FVector(1.f)) * OwnerPawn->GetActorTransform()).GetLocation();
 		FVector AverageFeetTargetsBackwardsWorld = (FTransform(FRotator(0.f), AverageFeetTargetsBackwards, FVector(1.f)) * OwnerPawn->GetActorTransform()).GetLocation();
 		FVector AverageFeetTargetsRightdWorld = (FTransform(FRotator(0.f), AverageFeetTargetsRight, FVector(1.f)) * OwnerPawn->GetActorTransform()).GetLocation();
 		FVector AverageFeetTargetsLeftWorld = (FTransform(FRotator(0.f), AverageFeetTargetsLeft, FVector(1.f)) * OwnerPawn->GetActorTransform()).GetLocation();
 
 		AsyncTask(ENamedThreads::GameThread, [=]() {
-			UWorld* World = LOwnerPawn->GetWorld();
+			UWorld* World = LOwnerPawn.IsValid() ? LOwnerPawn->GetWorld() : nullptr;
 
 			DrawDebugSphere(World, AverageFeetTargetsForwardWorld, 5.f, 12, FColor::FromHex("0013FF"));
 			DrawDebugSphere(World, AverageFeetTargetsBackwardsWorld, 5.f, 12, FColor::FromHex("0013FF"));
@@ -732,20 +1071,20 @@ void FAnimNode_SPW::ComputeBodyTransform()
 		});
 	}
 
-	ComputeBodyRotation(AverageFeetTargetsForward, AverageFeetTargetsBackwards, AverageFeetTargetsRight, AverageFeetTargetsLeft);
+	ComputeBodyRotation(FeetRelTargets, AverageFeetTargetsForward, AverageFeetTargetsBackwards, AverageFeetTargetsRight, AverageFeetTargetsLeft);
 	ComputeBodyLocation(AverageFeetTargetsForward, AverageFeetTargetsBackwards, AverageFeetTargetsRight, AverageFeetTargetsLeft);
 
-	if (bDebug && bIsPlaying)
+	if (bIsDebugDrawEnabled)
 	{
-		APawn* LOwnerPawn = OwnerPawn;
+		TWeakObjectPtr<APawn> LOwnerPawn = OwnerPawn;
 		float MeshBoxSize = SkeletalMeshComponent->SkeletalMesh->GetBounds().BoxExtent.Size();
 		FTransform DebugBoxTransform = FTransform(
-			OwnerPawn->GetActorRotation() + CurrentBodyRelRotation
+			OwnerPawn->GetActorQuat() * CurrentBodyRelRotation
 			, OwnerPawn->GetActorLocation() + CurrentBodyRelLocation
 			, FVector(1.f));
 
 		AsyncTask(ENamedThreads::GameThread, [=]() {
-			UWorld* World = LOwnerPawn->GetWorld();
+			UWorld* World = LOwnerPawn.IsValid() ? LOwnerPawn->GetWorld() : nullptr;
 			DrawDebugCoordinateSystem(World, DebugBoxTransform.GetLocation(), DebugBoxTransform.Rotator(), MeshBoxSize * 1.5, false, -1.f, 0, 1.f);
 		});
 	}
@@ -754,7 +1093,8 @@ void FAnimNode_SPW::ComputeBodyTransform()
 /*
  * -> BODY ROTATION
  */
-void FAnimNode_SPW::ComputeBodyRotation(FVector AverageFeetTargetsForward
+void FAnimNode_SPW::ComputeBodyRotation(const TSimpleProceduralWalk_LegArray<FVector>& FeetRelTargets
+	, FVector AverageFeetTargetsForward
 	, FVector AverageFeetTargetsBackwards
 	, FVector AverageFeetTargetsRight
 	, FVector AverageFeetTargetsLeft)
@@ -765,7 +1105,17 @@ void FAnimNode_SPW::ComputeBodyRotation(FVector AverageFeetTargetsForward
 	float PitchFromAcceleration = 0.f;
 	float RollFromAcceleration = 0.f;
 
-	if (bBodyRotateOnFeetLocations)
+	if (bBodyRotateOnFeetLocations && bBodyRotateOnFeetPlane)
+	{
+		// rotation based on the plane through all feet targets
+		float SlopeX;
+		float SlopeY;
+		SimpleProceduralWalk_PlaneFit::FitPlane(FeetRelTargets.GetData(), FeetRelTargets.Num(), SlopeX, SlopeY);
+
+		PitchFromFeetLocations = UKismetMathLibrary::DegAtan(SlopeX);
+		RollFromFeetLocations = -UKismetMathLibrary::DegAtan(SlopeY);
+	}
+	else if (bBodyRotateOnFeetLocations)
 	{
 		// rotation based on feet targets
 		PitchFromFeetLocations = UKismetMathLibrary::DegAtan(
@@ -786,29 +1136,48 @@ void FAnimNode_SPW::ComputeBodyRotation(FVector AverageFeetTargetsForward
 		// abs cos so 0 deg = 1 and +/-90 deg = 0
 		abs(FGenericPlatformMath::Cos(FMath::RadiansToDegrees(PitchFromFeetLocations)))
 		, 0.f, 1.f
-		, (1 - StepSlopeReductionMultiplier), 1.f);
+		, (1 - GetStepSlopeReductionMultiplier()), 1.f);
 
 	// map range clamped to StepSlopeReductionMultiplier -> 1
 	ReduceSlopeMultiplierRoll = UKismetMathLibrary::MapRangeClamped(
 		// abs cos so 0 deg = 1 and +/-90 deg = 0
 		abs(FGenericPlatformMath::Cos(FMath::RadiansToDegrees(RollFromFeetLocations)))
 		, 0.f, 1.f
-		, (1 - StepSlopeReductionMultiplier), 1.f);
+		, (1 - GetStepSlopeReductionMultiplier()), 1.f);
 
 	if (bBodyRotateOnAcceleration)
 	{
 		// rotation based on acceleration
-		PitchFromAcceleration = ForwardAcceleration * BodyAccelerationRotationMultiplier * -.2f;
-		RollFromAcceleration = RightAcceleration * BodyAccelerationRotationMultiplier * .2f;
+		PitchFromAcceleration = ForwardAcceleration * GetBodyAccelerationRotationMultiplier() * -.2f;
+		RollFromAcceleration = RightAcceleration * GetBodyAccelerationRotationMultiplier() * .2f;
 	}
 
 	// add & save
-	float BodyPitch = FMath::ClampAngle(PitchFromFeetLocations + PitchFromAcceleration, -MaxBodyRotation.Pitch, MaxBodyRotation.Pitch);
-	float BodyRoll = FMath::ClampAngle(RollFromFeetLocations + RollFromAcceleration, -MaxBodyRotation.Roll, MaxBodyRotation.Roll);
-	FRotator TargetBodyRelRotation = FRotator(BodyPitch, 0.f, BodyRoll);
+	float BodyPitch = FMath::ClampAngle(PitchFromFeetLocations + PitchFromAcceleration, -GetMaxBodyRotation().Pitch, GetMaxBodyRotation().Pitch);
+	float BodyRoll = FMath::ClampAngle(RollFromFeetLocations + RollFromAcceleration, -GetMaxBodyRotation().Roll, GetMaxBodyRotation().Roll);
+	const FQuat TargetBodyRelRotation = FRotator(BodyPitch, 0.f, BodyRoll).Quaternion();
+
+	// switch on skeletal axis
+	FRotator TargetBodyBoneRotator;
+	switch (SkeletalMeshForwardAxis)
+	{
+	case ESimpleProceduralWalk_MeshForwardAxis::NX:
+		TargetBodyBoneRotator = FRotator(-BodyPitch, 0.f, -BodyRoll);
+		break;
+	case ESimpleProceduralWalk_MeshForwardAxis::Y:
+		TargetBodyBoneRotator = FRotator(BodyRoll, 0.f, -BodyPitch);
+		break;
+	case ESimpleProceduralWalk_MeshForwardAxis::NY:
+		TargetBodyBoneRotator = FRotator(-BodyRoll, 0.f, BodyPitch);
+		break;
+	default:
+		TargetBodyBoneRotator = FRotator(BodyPitch, 0.f, BodyRoll);
+		break;
+	}
 
 	// interp rotation
-	CurrentBodyRelRotation = FMath::RInterpTo(CurrentBodyRelRotation, TargetBodyRelRotation, WorldDeltaSeconds, BodyRotationInterpSpeed);
+	CurrentBodyRelRotation = FMath::QInterpTo(CurrentBodyRelRotation, TargetBodyRelRotation, WorldDeltaSeconds, BodyRotationInterpSpeed);
+	CurrentBodyBoneRotation = FMath::QInterpTo(CurrentBodyBoneRotation, TargetBodyBoneRotator.Quaternion(), WorldDeltaSeconds, BodyRotationInterpSpeed);
 }
 
 /*
@@ -819,16 +1188,21 @@ void FAnimNode_SPW::ComputeBodyLocation(FVector AverageFeetTargetsForward
 	, FVector AverageFeetTargetsRight
 	, FVector AverageFeetTargetsLeft)
 {
+	// feet locations relative to actor
+	TSimpleProceduralWalk_LegArray<FVector> FeetRelLocations;
+	FeetRelLocations.SetNumUninitialized(LegsData.Num());
+	SimpleProceduralWalk_SpaceConversion::InverseTransformLocations(OwnerPawn->GetActorTransform(), LegsData.FootLocations.GetData(), FeetRelLocations.GetData(), LegsData.Num());
+
 	// get average feet locations
-	TArray<FVector> FeetLocations;
+	FVector AverageFeetRelLocation(0.f);
 	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
 	{
-		FeetLocations.Add(LegsData[LegIndex].FootLocation);
+		AverageFeetRelLocation += FeetRelLocations[LegIndex];
+	}
+	if (Legs.Num() > 0)
+	{
+		AverageFeetRelLocation /= Legs.Num();
 	}
-	FVector AverageFeetLocation = UKismetMathLibrary::GetVectorArrayAverage(FeetLocations);
-
-	// feet locations relative to actor
-	FVector AverageFeetRelLocation = UKismetMathLibrary::InverseTransformLocation(OwnerPawn->GetActorTransform(), AverageFeetLocation);
 
 	// Z reduction due to slope
 	float ReduceZForFeetLocations = FMath::Clamp(
@@ -854,60 +1228,67 @@ void FAnimNode_SPW::ComputeBodyLocation(FVector AverageFeetTargetsForward
 	CurrentBodyRelLocation = FMath::VInterpTo(CurrentBodyRelLocation, TargetBodyRelLocation, WorldDeltaSeconds, BodyLocationInterpSpeed);
 }
 
-void FAnimNode_SPW::GetAverageFeetTargets(FVector* AverageFeetTargetsForward
+void FAnimNode_SPW::GetAverageFeetTargets(const TSimpleProceduralWalk_LegArray<FVector>& FeetRelTargets
+	, FVector* AverageFeetTargetsForward
 	, FVector* AverageFeetTargetsBackwards
 	, FVector* AverageFeetTargetsRight
 	, FVector* AverageFeetTargetsLeft)
 {
-	// create foot forward / backwards / right / left location arrays
-	TArray<FVector> FeetTargetsForward;
-	TArray<FVector> FeetTargetsBackwards;
-	TArray<FVector> FeetTargetsRight;
-	TArray<FVector> FeetTargetsLeft;
+	// sum foot forward / backwards / right / left locations
+	FVector FeetTargetsForward(0.f);
+	FVector FeetTargetsBackwards(0.f);
+	FVector FeetTargetsRight(0.f);
+	FVector FeetTargetsLeft(0.f);
+	int32 NumFeetTargetsForward = 0;
+	int32 NumFeetTargetsBackwards = 0;
+	int32 NumFeetTargetsRight = 0;
+	int32 NumFeetTargetsLeft = 0;
 
 	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
 	{
-		// get local target transform
-		FVector FTarget = UKismetMathLibrary::InverseTransformLocation(OwnerPawn->GetActorTransform(), LegsData[LegIndex].FootTarget);
+		const FVector& FTarget = FeetRelTargets[LegIndex];
 		// add to front / backwards
-		if (LegsData[LegIndex].bIsForward)
+		if (LegsData.HasFlag(LegIndex, ESimpleProceduralWalk_LegFlags::Forward))
 		{
-			FeetTargetsForward.Add(FTarget);
+			FeetTargetsForward += FTarget;
+			NumFeetTargetsForward++;
 		}
-		if (LegsData[LegIndex].bIsBackwards)
+		if (LegsData.HasFlag(LegIndex, ESimpleProceduralWalk_LegFlags::Backwards))
 		{
-			FeetTargetsBackwards.Add(FTarget);
+			FeetTargetsBackwards += FTarget;
+			NumFeetTargetsBackwards++;
 		}
 
 		// add to right / left
-		if (LegsData[LegIndex].bIsRight)
+		if (LegsData.HasFlag(LegIndex, ESimpleProceduralWalk_LegFlags::Right))
 		{
-			FeetTargetsRight.Add(FTarget);
+			FeetTargetsRight += FTarget;
+			NumFeetTargetsRight++;
 		}
-		if (LegsData[LegIndex].bIsLeft)
+		if (LegsData.HasFlag(LegIndex, ESimpleProceduralWalk_LegFlags::Left))
 		{
-			FeetTargetsLeft.Add(FTarget);
+			FeetTargetsLeft += FTarget;
+			NumFeetTargetsLeft++;
 		}
 	}
 
-	*AverageFeetTargetsForward = UKismetMathLibrary::GetVectorArrayAverage(FeetTargetsForward);
-	*AverageFeetTargetsBackwards = UKismetMathLibrary::GetVectorArrayAverage(FeetTargetsBackwards);
-	*AverageFeetTargetsRight = UKismetMathLibrary::GetVectorArrayAverage(FeetTargetsRight);
-	*AverageFeetTargetsLeft = UKismetMathLibrary::GetVectorArrayAverage(FeetTargetsLeft);
+	*AverageFeetTargetsForward = NumFeetTargetsForward > 0 ? FeetTargetsForward / NumFeetTargetsForward : FVector(0.f);
+	*AverageFeetTargetsBackwards = NumFeetTargetsBackwards > 0 ? FeetTargetsBackwards / NumFeetTargetsBackwards : FVector(0.f);
+	*AverageFeetTargetsRight = NumFeetTargetsRight > 0 ? FeetTargetsRight / NumFeetTargetsRight : FVector(0.f);
+	*AverageFeetTargetsLeft = NumFeetTargetsLeft > 0 ? FeetTargetsLeft / NumFeetTargetsLeft : FVector(0.f);
 }
 
 void FAnimNode_SPW::ResetFeetTargetsAndLocations()
 {
-	// trace
+	// trace (all feet, regardless of the quality tier)
+	const int32 QualityTierTraceInterval = TraceInterval;
+	TraceInterval = 1;
 	SetFeetTargetLocations();
+	TraceInterval = QualityTierTraceInterval;
 
 	// reset feet
-	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
-	{
-		FVector FootLocation = (FTransform(FRotator(0.f), LegsData[LegIndex].TipBoneOriginalRelLocation, FVector(1.f)) * OwnerPawn->GetActorTransform()).GetLocation();
-		LegsData[LegIndex].FootLocation = FootLocation;
-		LegsData[LegIndex].FootUnplantLocation = FootLocation;
-	}
+	SimpleProceduralWalk_SpaceConversion::TransformLocations(OwnerPawn->GetActorTransform(), LegsData.TipBoneOriginalRelLocations.GetData(), LegsData.FootLocations.GetData(), LegsData.Num());
+	LegsData.FootUnplantLocations = LegsData.FootLocations;
 
 	// reset groups
 	CurrentGroupIndex = 0;
@@ -923,33 +1304,31 @@ void FAnimNode_SPW::ResetFeetTargetsAndLocations()
  */
 void FAnimNode_SPW::DebugShow()
 {
-	if (bDebug && bIsPlaying)
+	if (bIsDebugDrawEnabled)
 	{
-		APawn* LOwnerPawn = OwnerPawn;
+		TWeakObjectPtr<APawn> LOwnerPawn = OwnerPawn;
 
 		for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
 		{
-			FVector FootLocation = LegsData[LegIndex].FootLocation;
-			FRotator FootTargetRotation = LegsData[LegIndex].FootTargetRotation;
-			FRotator ComponentRotation = SkeletalMeshComponent->GetComponentRotation();
+			FVector FootLocation = LegsData.FootLocations[LegIndex];
+			FRotator FootRotation = (SkeletalMeshComponent->GetComponentQuat() * LegsData.FootTargetRotations[LegIndex]).Rotator();
 
 			AsyncTask(ENamedThreads::GameThread, [=]() {
-				UWorld* World = LOwnerPawn->GetWorld();
+				UWorld* World = LOwnerPawn.IsValid() ? LOwnerPawn->GetWorld() : nullptr;
 
 				// location
 				DrawDebugSphere(World, FootLocation, 10.f, 12, FColor::White);
 				// coords
-				FRotator FootRotation = UKismetMathLibrary::ComposeRotators(FootTargetRotation, ComponentRotation);
 				DrawDebugCoordinateSystem(World, FootLocation, FootRotation, 50.f, false, -1.f, 0, 1.f);
 
 			});
 
 			if (IsLegUnplanted(LegIndex))
 			{
-				FVector FootUnplantLocation = LegsData[LegIndex].FootUnplantLocation;
+				FVector FootUnplantLocation = LegsData.FootUnplantLocations[LegIndex];
 
 				AsyncTask(ENamedThreads::GameThread, [=]() {
-					UWorld* World = LOwnerPawn->GetWorld();
+					UWorld* World = LOwnerPawn.IsValid() ? LOwnerPawn->GetWorld() : nullptr;
 					DrawDebugSphere(World, FootUnplantLocation, 10.f, 12, FColor::Yellow);
 				});
 			}
@@ -968,7 +1347,7 @@ void FAnimNode_SPW::DebugShow()
 			GEngine->AddOnScreenDebugMessage(9994, 2.f, FColor::Red,
 				FString::Printf(TEXT("ReduceSlopeMultiplierPitch: %f | ReduceSlopeMultiplierRoll: %f"), ReduceSlopeMultiplierPitch, ReduceSlopeMultiplierRoll));
 			GEngine->AddOnScreenDebugMessage(9995, 2.f, FColor::White,
-				FString::Printf(TEXT("CurrentBodyRelRotationPitch: %f | CurrentBodyRelRotationRoll: %f"), CurrentBodyRelRotation.Pitch, CurrentBodyRelRotation.Roll));
+				FString::Printf(TEXT("CurrentBodyRelRotationPitch: %f | CurrentBodyRelRotationRoll: %f"), CurrentBodyRelRotation.Rotator().Pitch, CurrentBodyRelRotation.Rotator().Roll));
 		}
 		*/
 
@@ -1035,7 +1414,7 @@ void FAnimNode_SPW::EditorDebugShow(AActor* SkeletalMeshOwner)
 		for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
 		{
 			// get foot data
-			FSimpleProceduralWalk_Leg Leg = Legs[LegIndex];
+			const FSimpleProceduralWalk_Leg& Leg = Legs[LegIndex];
 
 			// Parent Bone Location
 			FVector ParentBoneLocation = SkeletalMeshComponent->GetSocketLocation(Leg.ParentBone.BoneName);
@@ -1046,27 +1425,22 @@ void FAnimNode_SPW::EditorDebugShow(AActor* SkeletalMeshOwner)
 
 			// Locations
 			FVector StartLocation = ParentBoneLocation + ForwardOffset + RightOffset;
-			FVector EndLocation = StartLocation - SkeletalMeshOwner->GetActorUpVector() * TraceLength;
-			StartLocation += SkeletalMeshOwner->GetActorUpVector() * TraceZOffset;
+			FVector EndLocation = StartLocation - SkeletalMeshOwner->GetActorUpVector() * GetTraceLength();
+			StartLocation += SkeletalMeshOwner->GetActorUpVector() * GetTraceZOffset();
 
 			// init hit
 			bool bIsHit = false;
 			FHitResult Hit = FHitResult(ForceInit);
 
-			// prepare ignore actors
-			TArray<AActor*> ActorsToIgnore;
-			ActorsToIgnore.Add(SkeletalMeshOwner);
+			// ignore self
+			FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(SimpleProceduralWalkTrace), ShouldTraceComplex(), SkeletalMeshOwner);
 
 			// line hit
-			bIsHit = UKismetSystemLibrary::LineTraceSingle(WorldContext
+			bIsHit = WorldContext->LineTraceSingleByChannel(Hit
 				, StartLocation
 				, EndLocation
-				, TraceChannel
-				, bTraceComplex
-				, ActorsToIgnore
-				, EDrawDebugTrace::None
-				, Hit
-				, true
+				, UEngineTypes::ConvertToCollisionChannel(GetTraceChannel())
+				, QueryParams
 			);
 
 			FTransform DebugTransform = FTransform(SkeletalMeshOwner->GetActorRotation(), Hit.ImpactPoint, FVector(1.f));
@@ -1089,66 +1463,102 @@ void FAnimNode_SPW::EditorDebugShow(AActor* SkeletalMeshOwner)
 // ---------- \/ ix ----------
 void FAnimNode_SPW::CallStepInterfaces(int32 GroupIndex, bool bIsDown)
 {
-	UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Calling Step interfaces."));
-
-	// pawn
-	if (OwnerPawn->GetClass()->ImplementsInterface(USimpleProceduralWalkInterface::StaticClass()))
+	if (bIsOffScreen && !bRaiseStepEventsOffScreen)
 	{
-		CallStepInterface(OwnerPawn, GroupIndex, bIsDown);
-	}
-	// anim instance
-	if (SkeletalMeshComponent->GetAnimInstance()->GetClass()->ImplementsInterface(USimpleProceduralWalkInterface::StaticClass()))
-	{
-		CallStepInterface(SkeletalMeshComponent->GetAnimInstance(), GroupIndex, bIsDown);
+		return;
 	}
-}
 
-void FAnimNode_SPW::CallStepInterface(UObject* InterfaceOwner, int32 GroupIndex, bool bIsDown)
-{
-	TArray<FVector> GroupFeetLocations;
+	UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Queueing Step events."));
+
+	FVector AverageFeetLocation(0.f);
 
 	// per foot event, loop feet in group
 	for (int LegIndex : LegGroups[GroupIndex].LegIndices)
 	{
-		GroupFeetLocations.Add(LegsData[LegIndex].FootLocation);
-
-		FName BoneName = Legs[LegIndex].TipBone.BoneName;
-		FVector FootLocation = LegsData[LegIndex].FootLocation;
-		FHitResult LastHit = LegsData[LegIndex].LastHit;
-
+		AverageFeetLocation += LegsData.FootLocations[LegIndex];
+
+		FStepEvent& StepEvent = StepEvents.AddDefaulted_GetRef();
+		StepEvent.bIsDown = bIsDown;
+		StepEvent.bIsGroup = false;
+		StepEvent.Index = LegIndex;
+		StepEvent.BoneName = Legs[LegIndex].TipBone.BoneName;
+		StepEvent.Location = LegsData.FootLocations[LegIndex];
 		if (bIsDown)
 		{
-			AsyncTask(ENamedThreads::GameThread, [=]() {
-				ISimpleProceduralWalkInterface::Execute_OnFootDown(InterfaceOwner, LegIndex, BoneName, FootLocation, LastHit);
-			});
-		}
-		else
-		{
-			AsyncTask(ENamedThreads::GameThread, [=]() {
-				ISimpleProceduralWalkInterface::Execute_OnFootUp(InterfaceOwner, LegIndex, BoneName, FootLocation);
-			});
+			StepEvent.Hit = LegsData.LastHits[LegIndex].ToHitResult();
 		}
 	}
 
 	// group event
-	FVector AverageFeetLocation = UKismetMathLibrary::GetVectorArrayAverage(GroupFeetLocations);
-	if (bIsDown)
+	if (LegGroups[GroupIndex].LegIndices.Num() > 0)
 	{
-		FHitResult FirstLegHit;
-		if (LegGroups[GroupIndex].LegIndices.Num() > 0)
-		{
-			FirstLegHit = LegsData[LegGroups[GroupIndex].LegIndices[0]].LastHit;
-		}
+		AverageFeetLocation /= LegGroups[GroupIndex].LegIndices.Num();
+	}
 
-		AsyncTask(ENamedThreads::GameThread, [=]() {
-			ISimpleProceduralWalkInterface::Execute_OnGroupDown(InterfaceOwner, GroupIndex, AverageFeetLocation, FirstLegHit);
-		});
+	FStepEvent& GroupEvent = StepEvents.AddDefaulted_GetRef();
+	GroupEvent.bIsDown = bIsDown;
+	GroupEvent.bIsGroup = true;
+	GroupEvent.Index = GroupIndex;
+	GroupEvent.Location = AverageFeetLocation;
+	if (bIsDown && LegGroups[GroupIndex].LegIndices.Num() > 0)
+	{
+		GroupEvent.Hit = LegsData.LastHits[LegGroups[GroupIndex].LegIndices[0]].ToHitResult();
 	}
-	else
+}
+
+void FAnimNode_SPW::FlushStepEvents()
+{
+	// game thread
+	if (StepEvents.Num() == 0)
 	{
-		AsyncTask(ENamedThreads::GameThread, [=]() {
-			ISimpleProceduralWalkInterface::Execute_OnGroupUp(InterfaceOwner, GroupIndex, AverageFeetLocation);
-		});
+		return;
+	}
+
+	UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Calling Step interfaces."));
+
+	// pawn
+	APawn* Pawn = OwnerPawn.Get();
+	if (Pawn != nullptr && Pawn->GetClass()->ImplementsInterface(USimpleProceduralWalkInterface::StaticClass()))
+	{
+		FlushStepEvents(Pawn);
+	}
+	// anim instance
+	UAnimInstance* AnimInstance = SkeletalMeshComponent.IsValid() ? SkeletalMeshComponent->GetAnimInstance() : nullptr;
+	if (AnimInstance != nullptr && AnimInstance->GetClass()->ImplementsInterface(USimpleProceduralWalkInterface::StaticClass()))
+	{
+		FlushStepEvents(AnimInstance);
+	}
+
+	// keep the capacity for the next update
+	StepEvents.Reset();
+}
+
+void FAnimNode_SPW::FlushStepEvents(UObject* InterfaceOwner)
+{
+	for (const FStepEvent& StepEvent : StepEvents)
+	{
+		if (StepEvent.bIsGroup)
+		{
+			if (StepEvent.bIsDown)
+			{
+				ISimpleProceduralWalkInterface::Execute_OnGroupDown(InterfaceOwner, StepEvent.Index, StepEvent.Location, StepEvent.Hit);
+			}
+			else
+			{
+				ISimpleProceduralWalkInterface::Execute_OnGroupUp(InterfaceOwner, StepEvent.Index, StepEvent.Location);
+			}
+		}
+		else
+		{
+			if (StepEvent.bIsDown)
+			{
+				ISimpleProceduralWalkInterface::Execute_OnFootDown(InterfaceOwner, StepEvent.Index, StepEvent.BoneName, StepEvent.Location, StepEvent.Hit);
+			}
+			else
+			{
+				ISimpleProceduralWalkInterface::Execute_OnFootUp(InterfaceOwner, StepEvent.Index, StepEvent.BoneName, StepEvent.Location);
+			}
+		}
 	}
 }
 
@@ -1156,20 +1566,33 @@ void FAnimNode_SPW::CallStepInterface(UObject* InterfaceOwner, int32 GroupIndex,
 void FAnimNode_SPW::SetSupportComponentData(int32 LegIndex, FVector RefLocation)
 {
 	// support component
-	UPrimitiveComponent* SupportComp = LegsData[LegIndex].LastHit.GetComponent();
+	UPrimitiveComponent* SupportComp = LegsData.LastHits[LegIndex].Component.Get();
 
-	if (IsValid(SupportComp))
+	if (IsValid(SupportComp) && SupportComp->Mobility == EComponentMobility::Static)
+	{
+		// static, no need to track it
+		LegsData.Supports[LegIndex].Component.Reset();
+		LegsData.Supports[LegIndex].bIsStatic = true;
+	}
+	else if (IsValid(SupportComp))
 	{
-		// store
-		LegsData[LegIndex].SupportComp = SupportComp;
+		// store (skinned mesh bones are resolved once here)
+		LegsData.Supports[LegIndex].SetComponent(SupportComp, LegsData.LastHits[LegIndex].BoneName);
+
+		// skinned mesh bone: the transform is copied before the next update
+		if (!LegsData.Supports[LegIndex].HasTransform())
+		{
+			LegsData.Supports[LegIndex].PlantLocation = RefLocation;
+			return;
+		}
 
 		// store current component transform
-		FTransform SupportCompCurrentTransform = LegsData[LegIndex].SupportComp->GetSocketTransform(LegsData[LegIndex].LastHit.BoneName);
+		FTransform SupportCompCurrentTransform = LegsData.Supports[LegIndex].GetTransform(SupportComp);
 
-		LegsData[LegIndex].SupportCompPreviousTransform = SupportCompCurrentTransform;
+		LegsData.Supports[LegIndex].PreviousTransform = SupportCompCurrentTransform;
 
 		// store location relative to comp bone
-		LegsData[LegIndex].RelLocationToSupportComp = UKismetMathLibrary::InverseTransformLocation(
+		LegsData.Supports[LegIndex].RelLocation = UKismetMathLibrary::InverseTransformLocation(
 			// component tranform
 			SupportCompCurrentTransform
 			// ref locations
@@ -1177,10 +1600,113 @@ void FAnimNode_SPW::SetSupportComponentData(int32 LegIndex, FVector RefLocation)
 	}
 	else
 	{
-		LegsData[LegIndex].SupportComp = nullptr;
+		LegsData.Supports[LegIndex].Component.Reset();
+		LegsData.Supports[LegIndex].bIsStatic = false;
+	}
+}
+
+void FAnimNode_SPW::UpdateSupportTickPrerequisites()
+{
+	// skinned mesh supports in use (never itself)
+	TSimpleProceduralWalk_LegArray<USkinnedMeshComponent*> SkinnedSupports;
+	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
+	{
+		const FSimpleProceduralWalk_LegSupport& Support = LegsData.Supports[LegIndex];
+		UPrimitiveComponent* SupportComp = Support.Component.Get();
+		if (SupportComp != nullptr && SupportComp != SkeletalMeshComponent.Get() && Support.BoneIndex != INDEX_NONE)
+		{
+			SkinnedSupports.AddUnique(static_cast<USkinnedMeshComponent*>(SupportComp));
+		}
+	}
+
+	// no leg supported anymore
+	for (int32 Index = TickPrerequisiteSupports.Num() - 1; Index >= 0; Index--)
+	{
+		if (!SkinnedSupports.Contains(TickPrerequisiteSupports[Index].Get()))
+		{
+			SetSupportTickPrerequisite(TickPrerequisiteSupports[Index], false);
+			TickPrerequisiteSupports.RemoveAtSwap(Index);
+		}
+	}
+
+	// new supports
+	for (USkinnedMeshComponent* SupportComp : SkinnedSupports)
+	{
+		if (!TickPrerequisiteSupports.Contains(SupportComp))
+		{
+			TickPrerequisiteSupports.Add(SupportComp);
+			SetSupportTickPrerequisite(SupportComp, true);
+		}
 	}
 }
 
+/*
+ * -> IS TICKING AFTER
+ * Does the tick function tick after the other one, through any chain of prerequisites?
+ */
+static bool IsTickingAfter(FTickFunction& TickFunction, const FTickFunction* OtherTickFunction)
+{
+	TArray<FTickFunction*, TInlineAllocator<16>> PendingTickFunctions;
+	TSet<FTickFunction*, DefaultKeyFuncs<FTickFunction*>, TInlineSetAllocator<16>> VisitedTickFunctions;
+	PendingTickFunctions.Add(&TickFunction);
+	VisitedTickFunctions.Add(&TickFunction);
+
+	while (PendingTickFunctions.Num() > 0)
+	{
+		FTickFunction* CurrentTickFunction = PendingTickFunctions.Pop(false);
+
+		for (FTickPrerequisite& Prerequisite : CurrentTickFunction->GetPrerequisites())
+		{
+			FTickFunction* PrerequisiteTickFunction = Prerequisite.Get();
+			if (PrerequisiteTickFunction == nullptr)
+			{
+				continue;
+			}
+			if (PrerequisiteTickFunction == OtherTickFunction)
+			{
+				return true;
+			}
+			if (!VisitedTickFunctions.Contains(PrerequisiteTickFunction))
+			{
+				VisitedTickFunctions.Add(PrerequisiteTickFunction);
+				PendingTickFunctions.Add(PrerequisiteTickFunction);
+			}
+		}
+	}
+
+	return false;
+}
+
+void FAnimNode_SPW::SetSupportTickPrerequisite(TWeakObjectPtr<USkinnedMeshComponent> SupportComp, bool bIsPrerequisite)
+{
+	// tick functions are only modified on the game thread
+	TWeakObjectPtr<USkeletalMeshComponent> LSkeletalMeshComponent = SkeletalMeshComponent;
+
+	AsyncTask(ENamedThreads::GameThread, [=]() {
+		if (!LSkeletalMeshComponent.IsValid() || !SupportComp.IsValid())
+		{
+			return;
+		}
+
+		if (!bIsPrerequisite)
+		{
+			UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("No longer ticking after support %s."), *SupportComp->GetName());
+			LSkeletalMeshComponent->PrimaryComponentTick.RemovePrerequisite(SupportComp.Get(), SupportComp->PrimaryComponentTick);
+			return;
+		}
+
+		// support already ticks after this mesh, directly or through others (for instance walkers on each other), would be a cycle
+		if (IsTickingAfter(SupportComp->PrimaryComponentTick, &LSkeletalMeshComponent->PrimaryComponentTick))
+		{
+			UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Not ticking after support %s, it ticks after this mesh."), *SupportComp->GetName());
+			return;
+		}
+
+		UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Ticking after support %s."), *SupportComp->GetName());
+		LSkeletalMeshComponent->PrimaryComponentTick.AddPrerequisite(SupportComp.Get(), SupportComp->PrimaryComponentTick);
+	});
+}
+
 float FAnimNode_SPW::GetReductionSlopeMultiplier()
 {
 	return abs(ForwardPercent) * ReduceSlopeMultiplierPitch + abs(RightPercent) * ReduceSlopeMultiplierRoll;
@@ -1188,12 +1714,12 @@ float FAnimNode_SPW::GetReductionSlopeMultiplier()
 
 bool FAnimNode_SPW::IsLegUnplanted(int32 LegIndex)
 {
-	return GroupsData[LegsData[LegIndex].GroupIndex].bIsUnplanted;
+	return GroupsData[LegsData.GroupIndices[LegIndex]].bIsUnplanted;
 }
 
 float FAnimNode_SPW::GetLegStepPercent(int32 LegIndex)
 {
-	return GroupsData[LegsData[LegIndex].GroupIndex].StepPercent;
+	return GroupsData[LegsData.GroupIndices[LegIndex]].StepPercent;
 }
 
 void FAnimNode_SPW::SetNextCurrentGroupIndex()
@@ -1207,64 +1733,14 @@ void FAnimNode_SPW::SetNextCurrentGroupIndex()
 
 float FAnimNode_SPW::GetStepHeightValue(float Time)
 {
-	// select step curves
-	switch (StepCurveType)
-	{
-	case ESimpleProceduralWalk_StepCurveType::ROBOT:
-	{
-		return StepHeightCurveRobot.Eval(Time);
-	}
-	case ESimpleProceduralWalk_StepCurveType::ORGANIC:
-	{
-		return StepHeightCurveOrganic.Eval(Time);
-	}
-	case ESimpleProceduralWalk_StepCurveType::CUSTOM:
-	{
-		if (CustomStepHeightCurve != nullptr)
-		{
-			return CustomStepHeightCurve->GetFloatValue(Time);
-		}
-		else
-		{
-			return 0.f;
-		}
-	}
-	default:
-	{
-		return 0.f;
-	}
-	}
+	// baked curves
+	return StepCurves != nullptr ? StepCurves->HeightCurve.Eval(Time) : 0.f;
 }
 
 float FAnimNode_SPW::GetStepDistanceValue(float Time)
 {
-	// select step curves
-	switch (StepCurveType)
-	{
-	case ESimpleProceduralWalk_StepCurveType::ROBOT:
-	{
-		return StepDistanceCurveRobot.Eval(Time);
-	}
-	case ESimpleProceduralWalk_StepCurveType::ORGANIC:
-	{
-		return StepDistanceCurveOrganic.Eval(Time);
-	}
-	case ESimpleProceduralWalk_StepCurveType::CUSTOM:
-	{
-		if (CustomStepHeightCurve != nullptr)
-		{
-			return CustomStepDistanceCurve->GetFloatValue(Time);
-		}
-		else
-		{
-			return 0.f;
-		}
-	}
-	default:
-	{
-		return 0.f;
-	}
-	}
+	// baked curves
+	return StepCurves != nullptr ? StepCurves->DistanceCurve.Eval(Time) : 0.f;
 }
 
 // ---------- \/ additional movement ----------
@@ -1278,10 +1754,15 @@ bool FAnimNode_SPW::IsFalling()
 		FVector RelMin = FVector(99999999.f);
 		FVector RelMax = FVector(-99999999.f);
 
+		// feet locations relative to actor
+		TSimpleProceduralWalk_LegArray<FVector> FeetRelLocations;
+		FeetRelLocations.SetNumUninitialized(LegsData.Num());
+		SimpleProceduralWalk_SpaceConversion::InverseTransformLocations(OwnerPawn->GetActorTransform(), LegsData.FootLocations.GetData(), FeetRelLocations.GetData(), LegsData.Num());
+
 		// define containing box based on feet
 		for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
 		{
-			FVector FootRelLocation = UKismetMathLibrary::InverseTransformLocation(OwnerPawn->GetActorTransform(), LegsData[LegIndex].FootLocation);
+			const FVector& FootRelLocation = FeetRelLocations[LegIndex];
 
 			if (FootRelLocation.X < RelMin.X) { RelMin.X = FootRelLocation.X; }
 			if (FootRelLocation.Y < RelMin.Y) { RelMin.Y = FootRelLocation.Y; }
@@ -1304,33 +1785,25 @@ bool FAnimNode_SPW::IsFalling()
 		bool bIsHit = false;
 		FHitResult Hit;
 
-		// prepare ignore actors
-		TArray<AActor*> ActorsToIgnore;
-		ActorsToIgnore.Add(OwnerPawn);
-
 		// line hit
-		bIsHit = UKismetSystemLibrary::BoxTraceSingle(WorldContext
+		bIsHit = WorldContext->SweepSingleByChannel(Hit
 			, OriginStart
 			, OriginEnd
-			, Extent
-			, Rotation
-			, TraceChannel
-			, bTraceComplex
-			, ActorsToIgnore
-			, EDrawDebugTrace::None
-			, Hit
-			, true
+			, Rotation.Quaternion()
+			, UEngineTypes::ConvertToCollisionChannel(GetTraceChannel())
+			, FCollisionShape::MakeBox(Extent)
+			, TraceQueryParams
 		);
 
 		// debug
-		if (bDebug && bIsPlaying)
+		if (bIsDebugDrawEnabled)
 		{
-			APawn* LOwnerPawn = OwnerPawn;
+			TWeakObjectPtr<APawn> LOwnerPawn = OwnerPawn;
 			FVector BoxOrigin = (OriginStart + OriginEnd) / 2.f;
 			FVector BoxExtent = Extent + FVector(0.f, 0.f, RelMin.Z * ZExtendMult / 2.f);
 
 			AsyncTask(ENamedThreads::GameThread, [=]() {
-				UWorld* World = LOwnerPawn->GetWorld();
+				UWorld* World = LOwnerPawn.IsValid() ? LOwnerPawn->GetWorld() : nullptr;
 				DrawDebugBox(World, BoxOrigin, BoxExtent, Rotation.Quaternion(), (bIsHit ? FColor::Orange : FColor::White));
 			});
 		}
@@ -1345,48 +1818,47 @@ bool FAnimNode_SPW::IsFalling()
 }
 
 // ---------- \/ scale ----------
-FVector FAnimNode_SPW::GetScaledLegOffset(FSimpleProceduralWalk_Leg Leg)
+FVector FAnimNode_SPW::GetScaledLegOffset(const FSimpleProceduralWalk_Leg& Leg)
 {
-	return bScaleWithSkeletalMesh ? (Leg.Offset * MeshScale) : Leg.Offset;
+	return Leg.Offset * SettingsScale;
 }
 
 float FAnimNode_SPW::GetScaledStepHeight()
 {
-	return bScaleWithSkeletalMesh ? (StepHeight * MeshScale.Z) : StepHeight;
+	return StepHeight * SettingsScale.Z;
 }
 
 float FAnimNode_SPW::GetScaledStepDistanceForward()
 {
-	return bScaleWithSkeletalMesh ? (StepDistanceForward * MeshScale.X) : StepDistanceForward;
+	return StepDistanceForward * SettingsScale.X;
 }
 
 float FAnimNode_SPW::GetScaledStepDistanceRight()
 {
-	return bScaleWithSkeletalMesh ? (StepDistanceRight * MeshScale.Y) : StepDistanceRight;
+	return StepDistanceRight * SettingsScale.Y;
 }
 
 float FAnimNode_SPW::GetScaledBodyZOffset()
 {
-	return bScaleWithSkeletalMesh ? (BodyZOffset * MeshScale.Z) : BodyZOffset;
+	return BodyZOffset * SettingsScale.Z;
 }
 
 float FAnimNode_SPW::GetScaledTraceLength()
 {
-	return bScaleWithSkeletalMesh ? (TraceLength * MeshScale.Z) : TraceLength;
+	return GetTraceLength() * SettingsScale.Z * TraceLengthScale;
 }
 
 float FAnimNode_SPW::GetScaledTraceZOffset()
 {
-	return bScaleWithSkeletalMesh ? (TraceZOffset * MeshScale.Z) : TraceZOffset;
+	return GetTraceZOffset() * SettingsScale.Z;
 }
 
 float FAnimNode_SPW::GetScaledMinStepDuration()
 {
-	return bScaleWithSkeletalMesh ? (MinStepDuration * MeshAverageScale) : MinStepDuration;
+	return GetMinStepDuration() * SettingsAverageScale;
 }
 
 float FAnimNode_SPW::GetAdaptedMinDistanceToUnplant(int32 LegIndex)
 {
-	float ScaledDistance = bScaleWithSkeletalMesh ? (MinDistanceToUnplant * MeshAverageScale) : MinDistanceToUnplant;
-	return ScaledDistance + LegsData[LegIndex].SupportCompDelta.Size();
+	return GetMinDistanceToUnplant() * SettingsAverageScale + LegsData.SupportCompDeltas[LegIndex].Size();
 }
@@ -0,0 +1,241 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#include "AnimNode_SPW.h"
+#include "SPWSwarmSubsystem.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+
+void FAnimNode_SPW::UpdatePoseSharing()
+{
+	bool bNewIsPoseClone = false;
+
+	if (bEnablePoseSharing
+		&& bIsInitialized
+		&& IsValid(WalkProfile)
+		&& !bIsOffScreen
+		&& !bIsFalling
+		&& (CurrentQualityTier == ESimpleProceduralWalk_QualityTier::FULL || CurrentQualityTier == ESimpleProceduralWalk_QualityTier::REDUCED))
+	{
+		// significance (already computed by the quality tiers)
+		const float PoseSharingCurrentSignificance = bEnableQualityTiers
+			? CurrentSignificance
+			: ComputeSignificance() * FSimpleProceduralWalk_Governor::Get().GetSignificanceScale();
+
+		USPWSwarmSubsystem* SwarmSubsystem = WorldContext->GetSubsystem<USPWSwarmSubsystem>();
+
+		if (PoseSharingCurrentSignificance < PoseSharingSignificance && SwarmSubsystem != nullptr && SkeletalMeshComponent->SkeletalMesh != nullptr)
+		{
+			// phase offset, so that clones of the same template do not walk in sync
+			ClonePhaseDelay = PointerHash(SkeletalMeshComponent.Get()) % SPW_POSE_HISTORY;
+
+			bNewIsPoseClone = SwarmSubsystem->CopyPose(SkeletalMeshComponent->SkeletalMesh->Skeleton
+				, WalkProfile
+				, SkeletalMeshComponent.Get()
+				, OwnerPawn->GetActorLocation()
+				, PoseTemplateComponent
+				, MaxClonesPerTemplate
+				, PoseSharingMaxDistance
+				, ClonePhaseDelay
+				, ClonePoseSnapshot)
+				&& ClonePoseSnapshot->Num() == LegsData.Num();
+		}
+	}
+
+	if (bNewIsPoseClone == bIsPoseClone)
+	{
+		return;
+	}
+
+	if (bNewIsPoseClone)
+	{
+		/* -> copies the pose of a template, steps stop */
+		UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Walker copies the pose of a template walker."));
+		bIsPoseTemplate = false;
+		for (FSimpleProceduralWalk_LegGroupData& GroupData : GroupsData)
+		{
+			GroupData.bIsUnplanted = false;
+			GroupData.StepPercent = 0.f;
+		}
+	}
+	else
+	{
+		/* -> computes its own pose again, feet are traced again */
+		UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Walker computes its own pose."));
+		PoseTemplateComponent.Reset();
+		ClonePoseSnapshot.Reset();
+		bForceReset = true;
+	}
+
+	bIsPoseClone = bNewIsPoseClone;
+}
+
+void FAnimNode_SPW::ComputeFromTemplate()
+{
+	const FTransform& ActorTransform = OwnerPawn->GetActorTransform();
+
+	// ground height under the walker (one trace instead of one per foot)
+	const FVector StartLocation = OwnerPawn->GetActorLocation();
+	const FVector EndLocation = StartLocation - OwnerPawn->GetActorUpVector() * (OwnerHalfHeight + GetScaledTraceLength());
+	FHitResult Hit;
+
+	const bool bIsHit = WorldContext->LineTraceSingleByChannel(Hit
+		, StartLocation
+		, EndLocation
+		, UEngineTypes::ConvertToCollisionChannel(GetTraceChannel())
+		, TraceQueryParams
+	);
+
+	const float TargetGroundOffset = bIsHit ? ActorTransform.InverseTransformPosition(Hit.ImpactPoint).Z + OwnerHalfHeight : 0.f;
+	CloneGroundOffset = FMath::FInterpTo(CloneGroundOffset, TargetGroundOffset, WorldDeltaSeconds, BodyLocationInterpSpeed);
+
+	// (for the copied solved bones)
+	CloneCSGroundOffset = SkeletalMeshComponent->GetComponentTransform().InverseTransformVector(OwnerPawn->GetActorUpVector() * CloneGroundOffset);
+
+	// feet, adapted to the ground height
+	const FSimpleProceduralWalk_PoseSnapshot& PoseSnapshot = *ClonePoseSnapshot;
+	TSimpleProceduralWalk_LegArray<FVector> FeetRelLocations;
+	FeetRelLocations.SetNumUninitialized(LegsData.Num());
+	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
+	{
+		FeetRelLocations[LegIndex] = PoseSnapshot.FootRelLocations[LegIndex] + FVector(0.f, 0.f, CloneGroundOffset);
+		LegsData.FootTargetRotations[LegIndex] = PoseSnapshot.FootTargetRotations[LegIndex];
+		LegsData.Flags[LegIndex] = PoseSnapshot.Flags[LegIndex];
+		LegsData.SupportCompDeltas[LegIndex] = FVector(0.f);
+	}
+	SimpleProceduralWalk_SpaceConversion::TransformLocations(ActorTransform, FeetRelLocations.GetData(), LegsData.FootLocations.GetData(), LegsData.Num());
+	LegsData.FootTargets = LegsData.FootLocations;
+
+	// body
+	CurrentBodyRelLocation = PoseSnapshot.BodyRelLocation;
+	CurrentBodyRelRotation = PoseSnapshot.BodyRelRotation;
+	CurrentBodyBoneRotation = PoseSnapshot.BodyBoneRotation;
+}
+
+void FAnimNode_SPW::PublishPose()
+{
+	if (bIsPoseClone || bIsOffScreen || bIsFalling || !IsValid(WalkProfile) || SkeletalMeshComponent->SkeletalMesh == nullptr)
+	{
+		return;
+	}
+
+	// without clones, only registered from time to time (so that clones can find it)
+	if (!bIsPoseTemplate && GFrameCounter < PoseRegisterFrame + SPW_POSE_REGISTER_FRAMES)
+	{
+		return;
+	}
+	PoseRegisterFrame = GFrameCounter;
+
+	USPWSwarmSubsystem* SwarmSubsystem = WorldContext->GetSubsystem<USPWSwarmSubsystem>();
+	if (SwarmSubsystem == nullptr)
+	{
+		return;
+	}
+
+	if (bIsPoseTemplate)
+	{
+		// solved bones are recorded in it at evaluation
+		if (!TemplatePoseSnapshot.IsValid())
+		{
+			TemplatePoseSnapshot = MakeShared<FSimpleProceduralWalk_PoseSnapshot, ESPMode::ThreadSafe>();
+		}
+		FSimpleProceduralWalk_PoseSnapshot& Snapshot = *TemplatePoseSnapshot;
+
+		// feet relative to actor
+		Snapshot.FootRelLocations.SetNumUninitialized(LegsData.Num());
+		SimpleProceduralWalk_SpaceConversion::InverseTransformLocations(OwnerPawn->GetActorTransform(), LegsData.FootLocations.GetData(), Snapshot.FootRelLocations.GetData(), LegsData.Num());
+		Snapshot.FootTargetRotations = LegsData.FootTargetRotations;
+		Snapshot.Flags = LegsData.Flags;
+
+		// body
+		Snapshot.BodyRelLocation = CurrentBodyRelLocation;
+		Snapshot.BodyRelRotation = CurrentBodyRelRotation;
+		Snapshot.BodyBoneRotation = CurrentBodyBoneRotation;
+	}
+
+	bIsPoseTemplate = SwarmSubsystem->PublishPose(SkeletalMeshComponent->SkeletalMesh->Skeleton
+		, WalkProfile
+		, SkeletalMeshComponent.Get()
+		, OwnerPawn->GetActorLocation()
+		, bIsPoseTemplate ? &TemplatePoseSnapshot : nullptr);
+
+	// oldest snapshot of the history, refilled unless clones still read it
+	if (TemplatePoseSnapshot.IsValid() && !TemplatePoseSnapshot.IsUnique())
+	{
+		TemplatePoseSnapshot.Reset();
+	}
+}
+
+void FAnimNode_SPW::RecordSolvedBones(FComponentSpacePoseContext& Output)
+{
+	if (!TemplatePoseSnapshot.IsValid())
+	{
+		TemplatePoseSnapshot = MakeShared<FSimpleProceduralWalk_PoseSnapshot, ESPMode::ThreadSafe>();
+	}
+	FSimpleProceduralWalk_PoseSnapshot& Snapshot = *TemplatePoseSnapshot;
+	const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
+
+	Snapshot.SolvedBoneTransforms.Reset();
+
+	// body
+	if (BodyBone.BoneIndex != INDEX_NONE && !bIsFalling)
+	{
+		Snapshot.SolvedBoneTransforms.Append(BodyBoneTransforms);
+	}
+
+	// legs
+	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
+	{
+		const FSPW_CCDIKLegChain& LegChain = CCDIKLegChains[LegIndex];
+		if (LegChain.bIsGathered)
+		{
+			Snapshot.SolvedBoneTransforms.Append(LegChain.bIsCacheHit ? LegChain.CachedOutputTransforms : LegChain.Transforms);
+		}
+	}
+
+	// sorted, without duplicates (chains may share their root bone)
+	Snapshot.SolvedBoneTransforms.Sort(FCompareBoneTransformIndex());
+	for (int32 Index = Snapshot.SolvedBoneTransforms.Num() - 1; Index > 0; Index--)
+	{
+		if (Snapshot.SolvedBoneTransforms[Index].BoneIndex == Snapshot.SolvedBoneTransforms[Index - 1].BoneIndex)
+		{
+			Snapshot.SolvedBoneTransforms.RemoveAt(Index, 1, false);
+		}
+	}
+
+	// compact pose indices are only valid for the same bone container
+	Snapshot.SolvedBonesAsset = BoneContainer.GetAsset();
+	Snapshot.SolvedBonesLODLevel = Output.AnimInstanceProxy->GetLODLevel();
+	Snapshot.SolvedBonesNumBones = BoneContainer.GetCompactPoseNumBones();
+}
+
+bool FAnimNode_SPW::ApplyTemplateBones(FComponentSpacePoseContext& Output)
+{
+	const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
+	if (!ClonePoseSnapshot.IsValid())
+	{
+		return false;
+	}
+
+	const FSimpleProceduralWalk_PoseSnapshot& PoseSnapshot = *ClonePoseSnapshot;
+	if (PoseSnapshot.SolvedBoneTransforms.Num() == 0
+		|| PoseSnapshot.SolvedBonesAsset != BoneContainer.GetAsset()
+		|| PoseSnapshot.SolvedBonesLODLevel != Output.AnimInstanceProxy->GetLODLevel()
+		|| PoseSnapshot.SolvedBonesNumBones != BoneContainer.GetCompactPoseNumBones())
+	{
+		return false;
+	}
+
+	// adapted to the ground height
+	CloneBoneTransforms = PoseSnapshot.SolvedBoneTransforms;
+	for (FBoneTransform& BoneTransform : CloneBoneTransforms)
+	{
+		BoneTransform.Transform.AddToTranslation(CloneCSGroundOffset);
+	}
+
+	Output.Pose.LocalBlendCSBoneTransforms(CloneBoneTransforms, QualityTierBlendWeight);
+	return true;
+}
@@ -0,0 +1,360 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#include "AnimNode_SPW.h"
+#include "Animation/AnimationPoseData.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/BlendSpace.h"
+#include "Animation/CustomAttributesRuntime.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+
+// constants
+static const float RECENTLY_RENDERED_TOLERANCE = .2f;
+static const float STALE_UPDATE_TOLERANCE = .1f;
+
+
+void FAnimNode_SPW::UpdateQualityTier()
+{
+	// time passed without updates (for instance above the LOD threshold): state is stale, reset & fade in
+	// (reduced rate ticking, such as Update Rate Optimizations, includes the skipped time in the delta)
+	const float WorldTimeSeconds = WorldContext->GetTimeSeconds();
+	if (LastUpdateTime >= 0.f && WorldTimeSeconds - LastUpdateTime > WorldDeltaSeconds + STALE_UPDATE_TOLERANCE)
+	{
+		bForceReset = true;
+		QualityTierBlendWeight = 0.f;
+	}
+	LastUpdateTime = WorldTimeSeconds;
+
+	// off screen walkers keep their tier until they are rendered again
+	if (bIsOffScreen)
+	{
+		return;
+	}
+
+	// tier from significance
+	ESimpleProceduralWalk_QualityTier NewQualityTier = ESimpleProceduralWalk_QualityTier::FULL;
+
+	if (bEnableQualityTiers)
+	{
+		// (scaled down by the governor, as if the walker was farther)
+		CurrentSignificance = ComputeSignificance() * FSimpleProceduralWalk_Governor::Get().GetSignificanceScale();
+
+		// thresholds of the Reduced, Body Only & Frozen tiers
+		const float Thresholds[] = { ReducedSignificance, BodyOnlySignificance, FrozenSignificance };
+		const int32 CurrentTierIndex = static_cast<int32>(CurrentQualityTier);
+		int32 NewTierIndex = 0;
+
+		for (int32 ThresholdIndex = 0; ThresholdIndex < UE_ARRAY_COUNT(Thresholds); ThresholdIndex++)
+		{
+			// going back to a better tier requires a higher significance (hysteresis)
+			const float Threshold = ThresholdIndex < CurrentTierIndex
+				? Thresholds[ThresholdIndex] * (1.f + SignificanceHysteresis)
+				: Thresholds[ThresholdIndex];
+
+			if (CurrentSignificance < Threshold)
+			{
+				NewTierIndex = ThresholdIndex + 1;
+			}
+		}
+
+		NewQualityTier = static_cast<ESimpleProceduralWalk_QualityTier>(NewTierIndex);
+	}
+	else
+	{
+		CurrentSignificance = 1.f;
+	}
+
+	SetQualityTier(NewQualityTier);
+
+	// fade the procedural pose out of / into the frozen tier
+	const float TargetBlendWeight = CurrentQualityTier == ESimpleProceduralWalk_QualityTier::FROZEN ? 0.f : 1.f;
+	QualityTierBlendWeight = TierBlendTime > 0.f
+		? FMath::FInterpConstantTo(QualityTierBlendWeight, TargetBlendWeight, WorldDeltaSeconds, 1.f / TierBlendTime)
+		: TargetBlendWeight;
+}
+
+void FAnimNode_SPW::UpdateBakedGait()
+{
+	// played in the frozen tier, until the procedural pose has faded in again
+	const bool bNewIsBakedGaitPlaying = BakedGaitBlendSpace != nullptr
+		&& bIsInitialized
+		&& (CurrentQualityTier == ESimpleProceduralWalk_QualityTier::FROZEN || (bIsBakedGaitPlaying && QualityTierBlendWeight < 1.f));
+
+	if (bNewIsBakedGaitPlaying && !bIsBakedGaitPlaying)
+	{
+		/* -> starts at the phase of the procedural gait (sequences are baked from phase 0, in whole cycles) */
+		UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Baked gait starts at phase %f."), GetGaitPhase());
+		BakedGaitPhase = GetGaitPhase() / FMath::Max(BakedGaitCycles, 1);
+	}
+
+	bIsBakedGaitPlaying = bNewIsBakedGaitPlaying;
+
+	if (!bIsBakedGaitPlaying)
+	{
+		BakedGaitSamples.Reset();
+		return;
+	}
+
+	// blend input, as baked: direction from the pawn forward (in degrees) & speed
+	const FVector RelVelocity = OwnerPawn->GetActorQuat().UnrotateVector(OwnerPawn->GetVelocity());
+	const float BlendSpeed = RelVelocity.Size2D();
+	const float BlendDirection = FMath::IsNearlyZero(BlendSpeed) ? 0.f : FMath::RadiansToDegrees(FMath::Atan2(RelVelocity.Y, RelVelocity.X));
+
+	if (!BakedGaitBlendSpace->GetSamplesFromBlendInput(FVector(BlendDirection, BlendSpeed, 0.f), BakedGaitSamples))
+	{
+		BakedGaitSamples.Reset();
+		return;
+	}
+
+	// samples are synced on the phase, which advances at their blended length
+	float BlendedLength = 0.f;
+	for (const FBlendSampleData& Sample : BakedGaitSamples)
+	{
+		if (Sample.Animation != nullptr)
+		{
+			BlendedLength += Sample.TotalWeight * Sample.Animation->SequenceLength;
+		}
+	}
+
+	if (BlendedLength > KINDA_SMALL_NUMBER)
+	{
+		BakedGaitPhase = FMath::Fmod(BakedGaitPhase + WorldDeltaSeconds / BlendedLength, 1.f);
+	}
+
+	for (FBlendSampleData& Sample : BakedGaitSamples)
+	{
+		if (Sample.Animation != nullptr)
+		{
+			Sample.Time = BakedGaitPhase * Sample.Animation->SequenceLength;
+		}
+	}
+}
+
+void FAnimNode_SPW::Evaluate_BakedGait(FComponentSpacePoseContext& Output)
+{
+	if (BakedGaitSamples.Num() == 0)
+	{
+		return;
+	}
+
+	const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
+
+	// baked pose
+	FCompactPose BakedPose;
+	BakedPose.SetBoneContainer(&BoneContainer);
+	FBlendedCurve BakedCurve;
+	BakedCurve.InitFrom(Output.Curve);
+	FStackCustomAttributes BakedAttributes;
+	FAnimationPoseData BakedPoseData(BakedPose, BakedCurve, BakedAttributes);
+	BakedGaitBlendSpace->GetAnimationPose(BakedGaitSamples, BakedPoseData);
+
+	// replaces the input pose as the procedural pose fades out (in local space)
+	FCompactPose InputPose;
+	InputPose.SetBoneContainer(&BoneContainer);
+	FCSPose<FCompactPose>::ConvertComponentPosesToLocalPoses(Output.Pose, InputPose);
+
+	const float BakedWeight = 1.f - QualityTierBlendWeight;
+	for (const FCompactPoseBoneIndex BoneIndex : InputPose.ForEachBoneIndex())
+	{
+		InputPose[BoneIndex].BlendWith(BakedPose[BoneIndex], BakedWeight);
+	}
+
+	Output.Pose.InitPose(InputPose);
+}
+
+float FAnimNode_SPW::GetGaitPhase() const
+{
+	const int32 NumGroups = GroupsData.Num();
+	if (NumGroups == 0)
+	{
+		return 0.f;
+	}
+
+	// the last unplanted group (the current group is the next one to unplant), once planted its step is complete
+	const int32 StepGroupIndex = (CurrentGroupIndex + NumGroups - 1) % NumGroups;
+	const float StepPercent = GroupsData[StepGroupIndex].bIsUnplanted ? GroupsData[StepGroupIndex].StepPercent : 1.f;
+	return FMath::Fmod((StepGroupIndex + StepPercent) / NumGroups, 1.f);
+}
+
+void FAnimNode_SPW::UpdateScalability()
+{
+	// read every update, so that changes apply without initializing again
+	bIsTraceComplex = ShouldTraceComplex() && FSimpleProceduralWalk_Scalability::IsTraceComplexAllowed();
+	TraceQueryParams.bTraceComplex = bIsTraceComplex;
+	TraceLengthScale = FSimpleProceduralWalk_Scalability::GetTraceLengthScale();
+	RadiusCheck = GetRadiusCheckMultiplier() * FSimpleProceduralWalk_Scalability::GetRadiusCheckScale() * FMath::Max(GetScaledStepDistanceForward(), GetScaledStepDistanceRight());
+
+	// solver
+	if (FSimpleProceduralWalk_Scalability::IsBasicSolverForced() != bIsBasicSolverForced)
+	{
+		bIsBasicSolverForced = !bIsBasicSolverForced;
+		if (bIsInitialized)
+		{
+			SelectEvaluationPolicies();
+		}
+	}
+}
+
+void FAnimNode_SPW::UpdateGovernor()
+{
+	FSimpleProceduralWalk_Governor& Governor = FSimpleProceduralWalk_Governor::Get();
+	Governor.BeginFrame(GFrameCounter);
+
+	// solver & trace interval
+	if (Governor.GetLevel() != GovernorLevel)
+	{
+		GovernorLevel = Governor.GetLevel();
+		if (bIsInitialized)
+		{
+			SelectEvaluationPolicies();
+		}
+	}
+}
+
+void FAnimNode_SPW::UpdateOffScreen()
+{
+	const bool bNewIsOffScreen = bEnableOffScreenMode && !bWasRecentlyRendered;
+
+	if (bNewIsOffScreen == bIsOffScreen)
+	{
+		return;
+	}
+
+	if (bNewIsOffScreen)
+	{
+		/* -> went off screen, supports are not tracked without traces */
+		UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Mesh is off screen."));
+		for (FSimpleProceduralWalk_LegSupport& Support : LegsData.Supports)
+		{
+			Support.Component.Reset();
+			Support.bIsStatic = false;
+		}
+	}
+	else
+	{
+		/* -> back on screen, re-sync with the ground */
+		UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Mesh is back on screen."));
+		bForceReset = true;
+	}
+
+	bIsOffScreen = bNewIsOffScreen;
+}
+
+float FAnimNode_SPW::ComputeSignificance()
+{
+	// provided
+	if (Significance >= 0.f)
+	{
+		return Significance;
+	}
+
+	// not visible
+	if (!bWasRecentlyRendered)
+	{
+		return 0.f;
+	}
+
+	// screen size seen from the closest local player camera (no camera -> full quality)
+	return ViewScreenSize < 0.f ? 1.f : FMath::Min(ViewScreenSize, 1.f);
+}
+
+void FAnimNode_SPW::GatherViews(const USkeletalMeshComponent* InSkeletalMeshComponent)
+{
+	// game thread: player controllers & camera managers are not read on the worker
+	bWasRecentlyRendered = InSkeletalMeshComponent->WasRecentlyRendered(RECENTLY_RENDERED_TOLERANCE);
+	ViewBounds = InSkeletalMeshComponent->Bounds;
+	ViewPoints.Reset();
+
+	// (same condition as UpdateView)
+	const UWorld* World = InSkeletalMeshComponent->GetWorld();
+	if (World == nullptr || !(bEnableQualityTiers || bEnablePoseSharing || (bEnableIkSolver && bAdaptiveIterations)))
+	{
+		return;
+	}
+
+	for (FConstPlayerControllerIterator Iterator = World->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		APlayerController* PlayerController = Iterator->Get();
+		if (IsValid(PlayerController) && PlayerController->IsLocalController() && IsValid(PlayerController->PlayerCameraManager))
+		{
+			const float HalfFOV = FMath::DegreesToRadians(FMath::Clamp(PlayerController->PlayerCameraManager->GetFOVAngle(), 1.f, 170.f) * .5f);
+			ViewPoints.Add({ PlayerController->PlayerCameraManager->GetCameraLocation(), FMath::Tan(HalfFOV) });
+		}
+	}
+}
+
+void FAnimNode_SPW::UpdateView()
+{
+	// distance & screen size seen from the local player cameras
+	// (screen size is the bounds radius over the half width of the view at the bounds distance)
+	ViewDistance = -1.f;
+	ViewScreenSize = -1.f;
+
+	for (const FViewPoint& ViewPoint : ViewPoints)
+	{
+		const float Distance = FVector::Dist(ViewBounds.Origin, ViewPoint.Location);
+		const float ScreenSize = ViewBounds.SphereRadius / FMath::Max(Distance * ViewPoint.HalfFOVTangent, KINDA_SMALL_NUMBER);
+
+		ViewDistance = ViewDistance < 0.f ? Distance : FMath::Min(ViewDistance, Distance);
+		ViewScreenSize = FMath::Max(ViewScreenSize, ScreenSize);
+	}
+}
+
+void FAnimNode_SPW::SetQualityTier(ESimpleProceduralWalk_QualityTier NewQualityTier)
+{
+	if (NewQualityTier == CurrentQualityTier)
+	{
+		return;
+	}
+
+	UE_LOG(LogSimpleProceduralWalk, Verbose, TEXT("Quality tier changed from %s to %s (significance: %f).")
+		, *UEnum::GetValueAsString(CurrentQualityTier)
+		, *UEnum::GetValueAsString(NewQualityTier)
+		, CurrentSignificance);
+
+	const bool bWasWalking = CurrentQualityTier == ESimpleProceduralWalk_QualityTier::FULL || CurrentQualityTier == ESimpleProceduralWalk_QualityTier::REDUCED;
+	const bool bIsWalking = NewQualityTier == ESimpleProceduralWalk_QualityTier::FULL || NewQualityTier == ESimpleProceduralWalk_QualityTier::REDUCED;
+
+	if (bWasWalking && !bIsWalking)
+	{
+		/* -> steps stop, feet are brought under the body */
+		for (FSimpleProceduralWalk_LegGroupData& GroupData : GroupsData)
+		{
+			GroupData.bIsUnplanted = false;
+			GroupData.StepPercent = 0.f;
+		}
+	}
+	else if (!bWasWalking && bIsWalking)
+	{
+		/* -> steps resume, feet are traced again */
+		bForceReset = true;
+	}
+
+	CurrentQualityTier = NewQualityTier;
+
+	// solver & trace interval
+	if (bIsInitialized)
+	{
+		SelectEvaluationPolicies();
+	}
+}
+
+void FAnimNode_SPW::ComputeFeetAtRest()
+{
+	// rest locations, under the body
+	SimpleProceduralWalk_SpaceConversion::TransformLocations(OwnerPawn->GetActorTransform()
+		, LegsData.TipBoneOriginalRelLocations.GetData()
+		, LegsData.FootTargets.GetData()
+		, LegsData.Num());
+
+	// interpolate
+	for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
+	{
+		LegsData.FootLocations[LegIndex] = FMath::VInterpTo(LegsData.FootLocations[LegIndex], LegsData.FootTargets[LegIndex], WorldDeltaSeconds, GetFeetInAirInterSpeed());
+		LegsData.FootTargetRotations[LegIndex] = FMath::QInterpTo(LegsData.FootTargetRotations[LegIndex], FQuat::Identity, WorldDeltaSeconds, GetFeetTipBonesRotationInterpSpeed());
+		LegsData.SupportCompDeltas[LegIndex] = FVector(0.f);
+	}
+}
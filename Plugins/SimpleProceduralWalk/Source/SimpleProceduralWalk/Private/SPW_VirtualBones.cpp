@@ -4,33 +4,65 @@
 #include "FABRIK.h"
 
 
+void SimpleProceduralWalk_VirtualBones::TransformTipBones(FCSPose<FCompactPose>& Pose
+	, const FTransform& ComponentTransform
+	, TArrayView<const FCompactPoseBoneIndex> TipBoneIndices
+	, const FVector* FootLocations
+	, const FQuat* FootTargetRotations
+	, float Alpha
+	, TArray<FBoneTransform>& OutTipBoneTransforms)
+{
+	OutTipBoneTransforms.Reset();
+
+	for (int32 LegIndex = 0; LegIndex < TipBoneIndices.Num(); LegIndex++)
+	{
+		const FCompactPoseBoneIndex CompactPoseBoneToModify = TipBoneIndices[LegIndex];
+		if (CompactPoseBoneToModify.GetInt() == INDEX_NONE)
+		{
+			continue;
+		}
+
+		FTransform NewBoneTM = Pose.GetComponentSpaceTransform(CompactPoseBoneToModify);
+
+		// translation (foot location is in world space)
+		NewBoneTM.SetTranslation(ComponentTransform.InverseTransformPosition(FootLocations[LegIndex]));
+
+		// rotation (foot rotation is in component space)
+		NewBoneTM.SetRotation(FootTargetRotations[LegIndex] * NewBoneTM.GetRotation());
+
+		OutTipBoneTransforms.Add(FBoneTransform(CompactPoseBoneToModify, NewBoneTM));
+	}
+
+	// merge all legs at once (parents before children)
+	if (OutTipBoneTransforms.Num() > 0)
+	{
+		OutTipBoneTransforms.Sort(FCompareBoneTransformIndex());
+		Pose.LocalBlendCSBoneTransforms(OutTipBoneTransforms, Alpha);
+	}
+}
+
 void FAnimNode_SPW::Evaluate_TransformBones(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
 {
 	if (bIsInitialized)
 	{
+		SCOPE_CYCLE_COUNTER(STAT_SPW_VirtualBones);
+
 		const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
 
+		// legs removed by LOD are skipped
+		TSimpleProceduralWalk_LegArray<FCompactPoseBoneIndex> TipBoneIndices;
 		for (int LegIndex = 0; LegIndex < Legs.Num(); LegIndex++)
 		{
-			FCompactPoseBoneIndex CompactPoseBoneToModify = TipBones[LegIndex].GetCompactPoseIndex(BoneContainer);
-			FTransform NewBoneTM = Output.Pose.GetComponentSpaceTransform(CompactPoseBoneToModify);
-			FTransform ComponentTransform = Output.AnimInstanceProxy->GetComponentTransform();
-
-			// translation
-			FAnimationRuntime::ConvertCSTransformToBoneSpace(ComponentTransform, Output.Pose, NewBoneTM, CompactPoseBoneToModify, EBoneControlSpace::BCS_WorldSpace);
-			NewBoneTM.SetTranslation(LegsData[LegIndex].FootLocation);
-			FAnimationRuntime::ConvertBoneSpaceTransformToCS(ComponentTransform, Output.Pose, NewBoneTM, CompactPoseBoneToModify, EBoneControlSpace::BCS_WorldSpace);
-			
-			// rotation
-			FAnimationRuntime::ConvertCSTransformToBoneSpace(ComponentTransform, Output.Pose, NewBoneTM, CompactPoseBoneToModify, BCS_ComponentSpace);
-			const FQuat BoneQuat(LegsData[LegIndex].FootTargetRotation);
-			NewBoneTM.SetRotation(BoneQuat * NewBoneTM.GetRotation());
-			FAnimationRuntime::ConvertBoneSpaceTransformToCS(ComponentTransform, Output.Pose, NewBoneTM, CompactPoseBoneToModify, BCS_ComponentSpace);
-
-			// merge
-			TArray<FBoneTransform> TempTransforms;
-			TempTransforms.Add(FBoneTransform(TipBones[LegIndex].GetCompactPoseIndex(BoneContainer), NewBoneTM));
-			Output.Pose.LocalBlendCSBoneTransforms(TempTransforms, 1.f);
+			TipBoneIndices.Add(LegsChainValid[LegIndex] ? TipBones[LegIndex].GetCompactPoseIndex(BoneContainer) : FCompactPoseBoneIndex(INDEX_NONE));
 		}
+
+		// world to component, once per evaluation
+		SimpleProceduralWalk_VirtualBones::TransformTipBones(Output.Pose
+			, Output.AnimInstanceProxy->GetComponentTransform()
+			, TipBoneIndices
+			, LegsData.FootLocations.GetData()
+			, LegsData.FootTargetRotations.GetData()
+			, QualityTierBlendWeight
+			, TipBoneTransforms);
 	}
 }
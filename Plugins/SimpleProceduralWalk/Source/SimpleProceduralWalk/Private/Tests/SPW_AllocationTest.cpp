@@ -0,0 +1,384 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/MemoryBase.h"
+#include "SPW.h"
+#include "SPW_AllocationTestAnimInstance.h"
+#include "Components/BoxComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/FloatingPawnMovement.h"
+#include "GameFramework/Pawn.h"
+#include "Rendering/SkeletalMeshLODRenderData.h"
+#include "Rendering/SkeletalMeshRenderData.h"
+
+// ---------- \/ allocation count ----------
+namespace SPWAllocationTest
+{
+	// counter of the current scope, per thread
+	static thread_local int32* NumAllocations = nullptr;
+}
+
+/** Forwards to the engine allocator, and counts the allocations made in FSPWScopedAllocationCount scopes. */
+class FSPWAllocationCounter : public FMalloc
+{
+public:
+	FSPWAllocationCounter(FMalloc* InInnerMalloc)
+		: InnerMalloc(InInnerMalloc)
+	{
+	}
+
+	virtual void* Malloc(SIZE_T Size, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Malloc(Size, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Size, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Realloc(Original, Size, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		InnerMalloc->Free(Original);
+	}
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return InnerMalloc->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return InnerMalloc->QuantizeSize(Count, Alignment);
+	}
+
+	virtual void Trim(bool bTrimThreadCaches) override
+	{
+		InnerMalloc->Trim(bTrimThreadCaches);
+	}
+
+	virtual void SetupTLSCachesOnCurrentThread() override
+	{
+		InnerMalloc->SetupTLSCachesOnCurrentThread();
+	}
+
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+	{
+		InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread();
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return InnerMalloc->IsInternallyThreadSafe();
+	}
+
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return TEXT("SPWAllocationCounter");
+	}
+
+private:
+	FMalloc* InnerMalloc;
+
+	void CountAllocation()
+	{
+		if (int32* NumAllocations = SPWAllocationTest::NumAllocations)
+		{
+			(*NumAllocations)++;
+		}
+	}
+};
+
+void FSPWScopedAllocationCount::Install()
+{
+	check(IsInGameThread());
+
+	// never removed: other threads may still be in the allocator, and free what was allocated through it
+	static FSPWAllocationCounter* AllocationCounter = nullptr;
+	if (AllocationCounter == nullptr)
+	{
+		AllocationCounter = new FSPWAllocationCounter(GMalloc);
+		GMalloc = AllocationCounter;
+	}
+}
+
+FSPWScopedAllocationCount::FSPWScopedAllocationCount(int32& InOutNumAllocations)
+	: PreviousNumAllocations(SPWAllocationTest::NumAllocations)
+{
+	SPWAllocationTest::NumAllocations = &InOutNumAllocations;
+}
+
+FSPWScopedAllocationCount::~FSPWScopedAllocationCount()
+{
+	SPWAllocationTest::NumAllocations = PreviousNumAllocations;
+}
+
+// ---------- \/ test walker ----------
+void FSPWAllocationTestNode::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
+{
+	NumEvaluations++;
+
+	FSPWScopedAllocationCount AllocationCount(NumEvaluateAllocations);
+	FAnimNode_SPW::EvaluateSkeletalControl_AnyThread(Output, OutBoneTransforms);
+}
+
+FSPWAllocationTestAnimInstanceProxy::FSPWAllocationTestAnimInstanceProxy(UAnimInstance* InAnimInstance)
+	: FAnimInstanceProxy(InAnimInstance)
+{
+	// two groups of diagonal legs
+	Node.BodyBone.BoneName = TEXT("pelvis");
+	Node.Legs.SetNum(SPWAllocationTestWalker::NUM_LEGS);
+	Node.LegGroups.SetNum(2);
+	for (int32 LegIndex = 0; LegIndex < SPWAllocationTestWalker::NUM_LEGS; LegIndex++)
+	{
+		Node.Legs[LegIndex].ParentBone.BoneName = SPWAllocationTestWalker::GetLegBoneName(LegIndex, TEXT("thigh"));
+		Node.Legs[LegIndex].TipBone.BoneName = SPWAllocationTestWalker::GetLegBoneName(LegIndex, TEXT("foot"));
+		Node.CCDIK_ResizeRotationLimitPerJoints(LegIndex, 3);
+		Node.LegGroups[(LegIndex + LegIndex / 2) % 2].LegIndices.Add(LegIndex);
+	}
+}
+
+void FSPWAllocationTestAnimInstanceProxy::Initialize(UAnimInstance* InAnimInstance)
+{
+	FAnimInstanceProxy::Initialize(InAnimInstance);
+
+	FAnimationInitializeContext InitContext(this);
+	Node.Initialize_AnyThread(InitContext);
+}
+
+void FSPWAllocationTestAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	// (not in an anim blueprint, so not gathered by the proxy)
+	Node.PreUpdate(InAnimInstance);
+}
+
+void FSPWAllocationTestAnimInstanceProxy::CacheBones()
+{
+	if (bBoneCachesInvalidated)
+	{
+		FAnimationCacheBonesContext CacheBonesContext(this);
+		Node.CacheBones_AnyThread(CacheBonesContext);
+		bBoneCachesInvalidated = false;
+	}
+}
+
+void FSPWAllocationTestAnimInstanceProxy::UpdateAnimationNode(const FAnimationUpdateContext& InContext)
+{
+	NumUpdates++;
+
+	FSPWScopedAllocationCount AllocationCount(NumUpdateAllocations);
+	Node.Update_AnyThread(InContext);
+}
+
+bool FSPWAllocationTestAnimInstanceProxy::Evaluate(FPoseContext& Output)
+{
+	FComponentSpacePoseContext ComponentSpaceOutput(this);
+	Node.EvaluateComponentSpace_AnyThread(ComponentSpaceOutput);
+
+	ComponentSpaceOutput.Pose.ConvertToLocalPoses(Output.Pose);
+	Output.Curve = ComponentSpaceOutput.Curve;
+	return true;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSPWSteadyStateAllocationTest, "SimpleProceduralWalk.Allocations.SteadyState", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+/*
+ * After warm-up, the per-frame leg data paths (legs data, space conversions, plane fit, step curves) do not allocate.
+ * The full node update is counted by SimpleProceduralWalk.Allocations.Node.
+ */
+bool FSPWSteadyStateAllocationTest::RunTest(const FString& Parameters)
+{
+	static const int32 NUM_LEGS = 6;
+	static const int32 NUM_FRAMES = 100;
+
+	// warm-up (set at initialization)
+	FSimpleProceduralWalk_LegsData LegsData;
+	LegsData.SetNum(NUM_LEGS);
+	for (int32 LegIndex = 0; LegIndex < NUM_LEGS; LegIndex++)
+	{
+		LegsData.TipBoneOriginalRelLocations[LegIndex] = FVector(FMath::Cos(LegIndex) * 100.f, FMath::Sin(LegIndex) * 100.f, -50.f);
+		LegsData.FootTargetRotations[LegIndex] = FQuat::Identity;
+	}
+	const FSimpleProceduralWalk_StepCurves& StepCurves = FSimpleProceduralWalk_StepCurves::GetDefault(ESimpleProceduralWalk_StepCurveType::ROBOT);
+
+	// count
+	FSPWScopedAllocationCount::Install();
+	int32 NumAllocations = 0;
+
+	float Checksum = 0.f;
+	for (int32 FrameIndex = 0; FrameIndex < NUM_FRAMES; FrameIndex++)
+	{
+		FSPWScopedAllocationCount AllocationCount(NumAllocations);
+
+		const FTransform ActorTransform(FRotator(0.f, FrameIndex * 3.f, 0.f), FVector(FrameIndex * 10.f, 0.f, 0.f));
+
+		// feet at rest & relative targets (inline leg arrays)
+		SimpleProceduralWalk_SpaceConversion::TransformLocations(ActorTransform, LegsData.TipBoneOriginalRelLocations.GetData(), LegsData.FootTargets.GetData(), NUM_LEGS);
+
+		TSimpleProceduralWalk_LegArray<FVector> FeetRelTargets;
+		FeetRelTargets.SetNumUninitialized(NUM_LEGS);
+		SimpleProceduralWalk_SpaceConversion::InverseTransformLocations(ActorTransform, LegsData.FootTargets.GetData(), FeetRelTargets.GetData(), NUM_LEGS);
+
+		// body plane
+		float SlopeX;
+		float SlopeY;
+		SimpleProceduralWalk_PlaneFit::FitPlane(FeetRelTargets.GetData(), NUM_LEGS, SlopeX, SlopeY);
+
+		// steps
+		for (int32 LegIndex = 0; LegIndex < NUM_LEGS; LegIndex++)
+		{
+			const float StepPercent = static_cast<float>((FrameIndex + LegIndex) % 20) / 20.f;
+			LegsData.FootLocations[LegIndex] = FMath::Lerp(LegsData.FootLocations[LegIndex], LegsData.FootTargets[LegIndex], StepCurves.DistanceCurve.Eval(StepPercent))
+				+ FVector(0.f, 0.f, StepCurves.HeightCurve.Eval(StepPercent));
+			LegsData.SetFlag(LegIndex, ESimpleProceduralWalk_LegFlags::EnableIK, StepPercent < .5f);
+		}
+
+		Checksum += SlopeX + SlopeY + LegsData.FootLocations[0].Z;
+	}
+
+	AddInfo(FString::Printf(TEXT("Checksum: %f"), Checksum));
+	TestEqual(TEXT("Allocations after warm-up"), NumAllocations, 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSPWNodeAllocationTest, "SimpleProceduralWalk.Allocations.Node", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+/*
+ * A walking pawn (skeletal mesh & anim instance running the node, over a ground box) in a game world without rendering.
+ * After warm-up, the node update (Update_AnyThread) and evaluation (EvaluateSkeletalControl_AnyThread) do not allocate.
+ * Only the allocations made inside these calls are counted, on whichever thread they run.
+ */
+bool FSPWNodeAllocationTest::RunTest(const FString& Parameters)
+{
+	static const int32 NUM_WARMUP_FRAMES = 60;
+	static const int32 NUM_FRAMES = 300;
+	static const float DELTA_SECONDS = 1.f / 60.f;
+	static const float PELVIS_HEIGHT = 60.f;
+	static const float WALK_SPEED = 150.f;
+
+	FSPWScopedAllocationCount::Install();
+
+	// skeleton & mesh (no geometry, a single LOD requiring all bones)
+	USkeleton* Skeleton = NewObject<USkeleton>(GetTransientPackage());
+	USkeletalMesh* SkeletalMesh = NewObject<USkeletalMesh>(GetTransientPackage());
+	{
+		FReferenceSkeletonModifier Modifier(SkeletalMesh->GetRefSkeleton(), Skeleton);
+		Modifier.Add(FMeshBoneInfo(TEXT("root"), TEXT("root"), INDEX_NONE), FTransform::Identity);
+		Modifier.Add(FMeshBoneInfo(TEXT("pelvis"), TEXT("pelvis"), 0), FTransform(FVector(0.f, 0.f, PELVIS_HEIGHT)));
+		for (int32 LegIndex = 0; LegIndex < SPWAllocationTestWalker::NUM_LEGS; LegIndex++)
+		{
+			const int32 ThighIndex = SkeletalMesh->GetRefSkeleton().GetRawBoneNum();
+			const FVector ThighLocation((LegIndex < 2 ? 40.f : -40.f), (LegIndex % 2 == 0 ? -25.f : 25.f), 0.f);
+			const FName ThighName = SPWAllocationTestWalker::GetLegBoneName(LegIndex, TEXT("thigh"));
+			const FName CalfName = SPWAllocationTestWalker::GetLegBoneName(LegIndex, TEXT("calf"));
+			const FName FootName = SPWAllocationTestWalker::GetLegBoneName(LegIndex, TEXT("foot"));
+			Modifier.Add(FMeshBoneInfo(ThighName, ThighName.ToString(), 1), FTransform(ThighLocation));
+			Modifier.Add(FMeshBoneInfo(CalfName, CalfName.ToString(), ThighIndex), FTransform(FVector(5.f, 0.f, -PELVIS_HEIGHT / 2.f)));
+			Modifier.Add(FMeshBoneInfo(FootName, FootName.ToString(), ThighIndex + 1), FTransform(FVector(-5.f, 0.f, -PELVIS_HEIGHT / 2.f)));
+		}
+	}
+	SkeletalMesh->SetSkeleton(Skeleton);
+	Skeleton->MergeAllBonesToBoneTree(SkeletalMesh);
+	SkeletalMesh->CalculateInvRefMatrices();
+
+	SkeletalMesh->AddLODInfo();
+	SkeletalMesh->AllocateResourceForRendering();
+	FSkeletalMeshLODRenderData* LODRenderData = new FSkeletalMeshLODRenderData();
+	for (int32 BoneIndex = 0; BoneIndex < SkeletalMesh->GetRefSkeleton().GetNum(); BoneIndex++)
+	{
+		LODRenderData->RequiredBones.Add(static_cast<FBoneIndexType>(BoneIndex));
+		LODRenderData->ActiveBoneIndices.Add(static_cast<FBoneIndexType>(BoneIndex));
+	}
+	SkeletalMesh->GetResourceForRendering()->LODRenderData.Add(LODRenderData);
+
+	// game world, physics only
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, NAME_None, nullptr, true, ERHIFeatureLevel::Num
+		, &UWorld::InitializationValues().InitializeScenes(false).AllowAudioPlayback(false).CreatePhysicsScene(true));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	// ground (top at Z = 0)
+	AActor* Ground = World->SpawnActor<AActor>();
+	UBoxComponent* GroundBox = NewObject<UBoxComponent>(Ground);
+	GroundBox->SetBoxExtent(FVector(100000.f, 100000.f, 10.f));
+	GroundBox->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	Ground->SetRootComponent(GroundBox);
+	GroundBox->RegisterComponent();
+	Ground->SetActorLocation(FVector(0.f, 0.f, -10.f));
+
+	// pawn (velocity read from its movement component, moved by the test)
+	APawn* Pawn = World->SpawnActor<APawn>();
+	USceneComponent* PawnRoot = NewObject<USceneComponent>(Pawn);
+	Pawn->SetRootComponent(PawnRoot);
+	PawnRoot->RegisterComponent();
+
+	UFloatingPawnMovement* PawnMovement = NewObject<UFloatingPawnMovement>(Pawn);
+	PawnMovement->RegisterComponent();
+	PawnMovement->SetUpdatedComponent(PawnRoot);
+
+	USkeletalMeshComponent* SkeletalMeshComponent = NewObject<USkeletalMeshComponent>(Pawn);
+	SkeletalMeshComponent->SetupAttachment(PawnRoot);
+	SkeletalMeshComponent->SetRelativeLocation(FVector(0.f, 0.f, -PELVIS_HEIGHT));
+	SkeletalMeshComponent->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+	SkeletalMeshComponent->SetAnimationMode(EAnimationMode::AnimationBlueprint);
+	SkeletalMeshComponent->SetAnimInstanceClass(USPWAllocationTestAnimInstance::StaticClass());
+	SkeletalMeshComponent->SetSkeletalMesh(SkeletalMesh);
+	SkeletalMeshComponent->RegisterComponent();
+
+	USPWAllocationTestAnimInstance* AnimInstance = Cast<USPWAllocationTestAnimInstance>(SkeletalMeshComponent->GetAnimInstance());
+	if (TestNotNull(TEXT("Anim instance"), AnimInstance))
+	{
+		FSPWAllocationTestAnimInstanceProxy& Proxy = AnimInstance->GetTestProxy();
+
+		// walk in a circle, turning
+		FVector Location(0.f, 0.f, PELVIS_HEIGHT);
+		float Yaw = 0.f;
+		for (int32 FrameIndex = 0; FrameIndex < NUM_WARMUP_FRAMES + NUM_FRAMES; FrameIndex++)
+		{
+			if (FrameIndex == NUM_WARMUP_FRAMES)
+			{
+				Proxy.NumUpdates = 0;
+				Proxy.NumUpdateAllocations = 0;
+				Proxy.Node.NumEvaluations = 0;
+				Proxy.Node.NumEvaluateAllocations = 0;
+			}
+
+			Yaw += 45.f * DELTA_SECONDS;
+			const FRotator Rotation(0.f, Yaw, 0.f);
+			PawnMovement->Velocity = Rotation.Vector() * WALK_SPEED;
+			Location += PawnMovement->Velocity * DELTA_SECONDS;
+			Pawn->SetActorLocationAndRotation(Location, Rotation);
+
+			// (no tick function: evaluated on the game thread)
+			SkeletalMeshComponent->TickAnimation(DELTA_SECONDS, false);
+			SkeletalMeshComponent->RefreshBoneTransforms();
+		}
+
+		AddInfo(FString::Printf(TEXT("%d frames: %d updates, %d evaluations."), NUM_FRAMES, Proxy.NumUpdates, Proxy.Node.NumEvaluations));
+		TestEqual(TEXT("Updates"), Proxy.NumUpdates, NUM_FRAMES);
+		TestEqual(TEXT("Evaluations"), Proxy.Node.NumEvaluations, NUM_FRAMES);
+		TestEqual(TEXT("Update_AnyThread allocations after warm-up"), Proxy.NumUpdateAllocations, 0);
+		TestEqual(TEXT("EvaluateSkeletalControl_AnyThread allocations after warm-up"), Proxy.Node.NumEvaluateAllocations, 0);
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,82 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "AnimNode_SPW.h"
+#include "SPW_AllocationTestAnimInstance.generated.h"
+
+/** Counts the allocations made by the current thread while in scope. */
+class FSPWScopedAllocationCount
+{
+public:
+	/** Installs the counting allocator (game thread). It is installed once, and never removed. */
+	static void Install();
+
+	FSPWScopedAllocationCount(int32& InOutNumAllocations);
+	~FSPWScopedAllocationCount();
+
+private:
+	int32* PreviousNumAllocations;
+};
+
+/** Test walker: legs of a thigh, a calf & a foot, under the pelvis. */
+namespace SPWAllocationTestWalker
+{
+	static const int32 NUM_LEGS = 4;
+
+	inline FName GetLegBoneName(int32 LegIndex, const TCHAR* BoneName)
+	{
+		return FName(*FString::Printf(TEXT("leg_%d_%s"), LegIndex, BoneName));
+	}
+}
+
+/** Walk node, counting the allocations made by its evaluation. */
+struct FSPWAllocationTestNode : public FAnimNode_SPW
+{
+	int32 NumEvaluations = 0;
+	int32 NumEvaluateAllocations = 0;
+
+	virtual void EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) override;
+};
+
+/** Runs the test walker node, counting the allocations made by its update. */
+class FSPWAllocationTestAnimInstanceProxy : public FAnimInstanceProxy
+{
+public:
+	FSPWAllocationTestAnimInstanceProxy(UAnimInstance* InAnimInstance);
+
+	FSPWAllocationTestNode Node;
+	int32 NumUpdates = 0;
+	int32 NumUpdateAllocations = 0;
+
+protected:
+	// FAnimInstanceProxy interface
+	virtual void Initialize(UAnimInstance* InAnimInstance) override;
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+	virtual void CacheBones() override;
+	virtual void UpdateAnimationNode(const FAnimationUpdateContext& InContext) override;
+	virtual bool Evaluate(FPoseContext& Output) override;
+};
+
+/** Anim instance running the test walker node (automation tests only). */
+UCLASS(Transient, NotBlueprintable, HideDropdown)
+class USPWAllocationTestAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+public:
+	FSPWAllocationTestAnimInstanceProxy& GetTestProxy()
+	{
+		return GetProxyOnGameThread<FSPWAllocationTestAnimInstanceProxy>();
+	}
+
+protected:
+	// UAnimInstance interface
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override
+	{
+		return new FSPWAllocationTestAnimInstanceProxy(this);
+	}
+};
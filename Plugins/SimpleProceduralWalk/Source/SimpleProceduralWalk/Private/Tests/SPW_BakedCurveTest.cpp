@@ -0,0 +1,66 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "SPW.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// maximum deviation allowed, in percentage of the step height / distance
+static const float MAX_BAKED_CURVE_DEVIATION = .005f;
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSPWBakedCurveDeviationTest, "SimpleProceduralWalk.StepCurves.BakedDeviation", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter)
+
+/*
+ * The baked step curves stay within MAX_BAKED_CURVE_DEVIATION of their source curves (built-in & custom).
+ */
+bool FSPWBakedCurveDeviationTest::RunTest(const FString& Parameters)
+{
+	// built-in
+	const ESimpleProceduralWalk_StepCurveType BuiltInTypes[] = { ESimpleProceduralWalk_StepCurveType::ROBOT, ESimpleProceduralWalk_StepCurveType::ORGANIC };
+
+	for (ESimpleProceduralWalk_StepCurveType StepCurveType : BuiltInTypes)
+	{
+		const FSimpleProceduralWalk_StepCurves& StepCurves = FSimpleProceduralWalk_StepCurves::GetDefault(StepCurveType);
+		const float HeightDeviation = StepCurves.HeightCurve.GetMaxDeviation(SimpleProceduralWalk_StepCurves::CreateHeightCurve(StepCurveType));
+		const float DistanceDeviation = StepCurves.DistanceCurve.GetMaxDeviation(SimpleProceduralWalk_StepCurves::CreateDistanceCurve());
+
+		AddInfo(FString::Printf(TEXT("%s: height deviation %f, distance deviation %f."), *UEnum::GetValueAsString(StepCurveType), HeightDeviation, DistanceDeviation));
+		TestTrue(FString::Printf(TEXT("%s height deviation"), *UEnum::GetValueAsString(StepCurveType)), HeightDeviation <= MAX_BAKED_CURVE_DEVIATION);
+		TestTrue(FString::Printf(TEXT("%s distance deviation"), *UEnum::GetValueAsString(StepCurveType)), DistanceDeviation <= MAX_BAKED_CURVE_DEVIATION);
+	}
+
+	// custom (a smooth curve, with a fast rise and a slow fall)
+	FRichCurve CustomCurve;
+	CustomCurve.AddKey(0.f, 0.f);
+	CustomCurve.AddKey(.15f, .8f);
+	CustomCurve.AddKey(.35f, 1.f);
+	CustomCurve.AddKey(.8f, .4f);
+	CustomCurve.AddKey(1.f, 0.f);
+	for (FRichCurveKey& Key : CustomCurve.Keys)
+	{
+		Key.InterpMode = ERichCurveInterpMode::RCIM_Cubic;
+		Key.TangentMode = ERichCurveTangentMode::RCTM_Auto;
+	}
+	CustomCurve.AutoSetTangents();
+
+	FSimpleProceduralWalk_BakedCurve BakedCustomCurve;
+	BakedCustomCurve.Bake(CustomCurve);
+	const float CustomDeviation = BakedCustomCurve.GetMaxDeviation(CustomCurve);
+
+	AddInfo(FString::Printf(TEXT("Custom: deviation %f."), CustomDeviation));
+	TestTrue(TEXT("Custom deviation"), CustomDeviation <= MAX_BAKED_CURVE_DEVIATION);
+
+	// exact on samples, clamped outside [0, 1]
+	for (int32 SampleIndex = 0; SampleIndex < SPW_BAKED_CURVE_SAMPLES; SampleIndex++)
+	{
+		const float Time = static_cast<float>(SampleIndex) / (SPW_BAKED_CURVE_SAMPLES - 1);
+		TestEqual(FString::Printf(TEXT("Sample %d"), SampleIndex), BakedCustomCurve.Eval(Time), CustomCurve.Eval(Time), KINDA_SMALL_NUMBER);
+	}
+	TestEqual(TEXT("Before start"), BakedCustomCurve.Eval(-1.f), CustomCurve.Eval(0.f), KINDA_SMALL_NUMBER);
+	TestEqual(TEXT("After end"), BakedCustomCurve.Eval(2.f), CustomCurve.Eval(1.f), KINDA_SMALL_NUMBER);
+
+	return true;
+}
+
+#endif
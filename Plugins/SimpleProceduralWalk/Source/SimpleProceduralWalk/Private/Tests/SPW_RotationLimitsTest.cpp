@@ -0,0 +1,62 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "SPW.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSPWRotationLimitsLODTest, "SimpleProceduralWalk.RotationLimits.LOD", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter)
+
+/*
+ * Limits of the joints removed by LOD go to the closest remaining child (the first link is never rotated),
+ * or to the closest remaining ancestor for the joints after the last remaining one.
+ */
+bool FSPWRotationLimitsLODTest::RunTest(const FString& Parameters)
+{
+	// parent bone, two middle bones, tip bone
+	const TArray<float> RotationLimitPerJoints = { 30.f, 40.f, 50.f, 20.f };
+
+	struct FCase
+	{
+		const TCHAR* Name;
+		TArray<bool> bIsJointRequired;
+		TArray<float> ExpectedDegrees;
+	};
+
+	const TArray<FCase> Cases = {
+		{ TEXT("All bones"), { true, true, true, true }, { 0.f, 30.f, 40.f, 50.f, 20.f } },
+		{ TEXT("Middle bone stripped"), { true, false, true, true }, { 0.f, 30.f, 90.f, 20.f } },
+		{ TEXT("Both middle bones stripped"), { true, false, false, true }, { 0.f, 30.f, 110.f } },
+		{ TEXT("Parent bone stripped"), { false, true, true, true }, { 0.f, 70.f, 50.f, 20.f } },
+		{ TEXT("Tip bone stripped"), { true, true, true, false }, { 0.f, 30.f, 40.f, 70.f } },
+		{ TEXT("Parent & middle bone stripped"), { false, false, true, true }, { 0.f, 120.f, 20.f } },
+	};
+
+	TArray<float> RotationLimits;
+
+	for (const FCase& Case : Cases)
+	{
+		SimpleProceduralWalk_RotationLimits::Remap(RotationLimitPerJoints, Case.bIsJointRequired, RotationLimits);
+
+		if (TestEqual(FString::Printf(TEXT("%s: number of links"), Case.Name), RotationLimits.Num(), Case.ExpectedDegrees.Num()))
+		{
+			TestEqual(FString::Printf(TEXT("%s: root link"), Case.Name), RotationLimits[0], 0.f);
+
+			for (int32 LinkIndex = 1; LinkIndex < RotationLimits.Num(); LinkIndex++)
+			{
+				TestEqual(FString::Printf(TEXT("%s: link %d"), Case.Name, LinkIndex), RotationLimits[LinkIndex], FMath::DegreesToRadians(Case.ExpectedDegrees[LinkIndex]), 1.e-4f);
+			}
+		}
+	}
+
+	// clamped to PI
+	const TArray<float> WideRotationLimitPerJoints = { 120.f, 120.f, 80.f };
+	const TArray<bool> bIsMiddleStripped = { true, false, true };
+	SimpleProceduralWalk_RotationLimits::Remap(WideRotationLimitPerJoints, bIsMiddleStripped, RotationLimits);
+	TestEqual(TEXT("Clamped to PI"), RotationLimits.Last(), PI, 1.e-4f);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,83 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Kismet/KismetMathLibrary.h"
+#include "SPW.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSPWSpaceConversionBenchmark, "SimpleProceduralWalk.SpaceConversion.Benchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+/*
+ * Batch space conversion against the per-leg path it replaced (UKismetMathLibrary per leg, with the transform fetched per leg).
+ * Results must match, timings are reported.
+ */
+bool FSPWSpaceConversionBenchmark::RunTest(const FString& Parameters)
+{
+	static const int32 NUM_LEGS = 8;
+	static const int32 NUM_ITERATIONS = 200000;
+
+	FRandomStream Random(1234);
+	const FTransform ActorTransform(FRotator(10.f, 35.f, -5.f), FVector(1200.f, -300.f, 90.f), FVector(1.2f));
+
+	TSimpleProceduralWalk_LegArray<FVector> WorldLocations;
+	TSimpleProceduralWalk_LegArray<FVector> PerLegRelLocations;
+	TSimpleProceduralWalk_LegArray<FVector> BatchRelLocations;
+	WorldLocations.SetNumUninitialized(NUM_LEGS);
+	PerLegRelLocations.SetNumUninitialized(NUM_LEGS);
+	BatchRelLocations.SetNumUninitialized(NUM_LEGS);
+
+	for (int32 LegIndex = 0; LegIndex < NUM_LEGS; LegIndex++)
+	{
+		WorldLocations[LegIndex] = ActorTransform.GetLocation() + Random.GetUnitVector() * Random.FRandRange(50.f, 200.f);
+	}
+
+	// the transform is copied per leg, as GetActorTransform() was
+	const FTransform* volatile ActorTransformPtr = &ActorTransform;
+	float Checksum = 0.f;
+
+	// per leg
+	const double PerLegStartSeconds = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < NUM_ITERATIONS; Iteration++)
+	{
+		for (int32 LegIndex = 0; LegIndex < NUM_LEGS; LegIndex++)
+		{
+			PerLegRelLocations[LegIndex] = UKismetMathLibrary::InverseTransformLocation(FTransform(*ActorTransformPtr), WorldLocations[LegIndex]);
+		}
+		Checksum += PerLegRelLocations[Iteration % NUM_LEGS].X;
+	}
+	const double PerLegSeconds = FPlatformTime::Seconds() - PerLegStartSeconds;
+
+	// batch
+	const double BatchStartSeconds = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < NUM_ITERATIONS; Iteration++)
+	{
+		SimpleProceduralWalk_SpaceConversion::InverseTransformLocations(*ActorTransformPtr, WorldLocations.GetData(), BatchRelLocations.GetData(), NUM_LEGS);
+		Checksum += BatchRelLocations[Iteration % NUM_LEGS].X;
+	}
+	const double BatchSeconds = FPlatformTime::Seconds() - BatchStartSeconds;
+
+	AddInfo(FString::Printf(TEXT("%d legs x %d iterations: per leg %.3f ms, batch %.3f ms (x%.2f), checksum %f.")
+		, NUM_LEGS
+		, NUM_ITERATIONS
+		, PerLegSeconds * 1000.
+		, BatchSeconds * 1000.
+		, BatchSeconds > 0. ? PerLegSeconds / BatchSeconds : 0.
+		, Checksum));
+
+	// same results, both ways
+	TSimpleProceduralWalk_LegArray<FVector> BackToWorldLocations;
+	BackToWorldLocations.SetNumUninitialized(NUM_LEGS);
+	SimpleProceduralWalk_SpaceConversion::TransformLocations(ActorTransform, BatchRelLocations.GetData(), BackToWorldLocations.GetData(), NUM_LEGS);
+
+	for (int32 LegIndex = 0; LegIndex < NUM_LEGS; LegIndex++)
+	{
+		TestTrue(FString::Printf(TEXT("Leg %d: inverse transform"), LegIndex), BatchRelLocations[LegIndex].Equals(PerLegRelLocations[LegIndex], .01f));
+		TestTrue(FString::Printf(TEXT("Leg %d: transform"), LegIndex), BackToWorldLocations[LegIndex].Equals(ActorTransform.TransformPosition(BatchRelLocations[LegIndex]), .01f));
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,166 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Animation/Skeleton.h"
+#include "AnimationRuntime.h"
+#include "BonePose.h"
+#include "SPW.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSPWVirtualBonesComponentSpaceTest, "SimpleProceduralWalk.VirtualBones.ComponentSpaceOutput", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::SmokeFilter)
+
+/*
+ * The tip bone output written directly in component space gives the same transform as the previous world space round trip
+ * (ConvertCSTransformToBoneSpace / ConvertBoneSpaceTransformToCS in BCS_WorldSpace, then in BCS_ComponentSpace which does nothing).
+ */
+bool FSPWVirtualBonesComponentSpaceTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(1234);
+
+	for (int32 CaseIndex = 0; CaseIndex < 64; CaseIndex++)
+	{
+		const FTransform ComponentTransform(
+			FRotator(Random.FRandRange(-180.f, 180.f), Random.FRandRange(-180.f, 180.f), Random.FRandRange(-180.f, 180.f))
+			, Random.GetUnitVector() * Random.FRandRange(0.f, 10000.f)
+			, FVector(Random.FRandRange(.5f, 2.f)));
+		const FTransform TipBoneCSTransform(
+			FRotator(Random.FRandRange(-180.f, 180.f), Random.FRandRange(-180.f, 180.f), Random.FRandRange(-180.f, 180.f))
+			, Random.GetUnitVector() * Random.FRandRange(0.f, 200.f));
+		const FVector FootLocation = ComponentTransform.GetLocation() + Random.GetUnitVector() * Random.FRandRange(0.f, 200.f);
+		const FQuat FootTargetRotation = FRotator(Random.FRandRange(-30.f, 30.f), 0.f, Random.FRandRange(-30.f, 30.f)).Quaternion();
+
+		// previous path: world space round trip
+		FTransform PreviousTM = TipBoneCSTransform * ComponentTransform;
+		PreviousTM.SetTranslation(FootLocation);
+		PreviousTM = PreviousTM.GetRelativeTransform(ComponentTransform);
+		PreviousTM.SetRotation(FootTargetRotation * PreviousTM.GetRotation());
+
+		// current path: component space
+		FTransform CurrentTM = TipBoneCSTransform;
+		CurrentTM.SetTranslation(ComponentTransform.InverseTransformPosition(FootLocation));
+		CurrentTM.SetRotation(FootTargetRotation * CurrentTM.GetRotation());
+
+		TestTrue(FString::Printf(TEXT("Case %d: translation"), CaseIndex), PreviousTM.GetTranslation().Equals(CurrentTM.GetTranslation(), .05f));
+		TestTrue(FString::Printf(TEXT("Case %d: rotation"), CaseIndex), PreviousTM.GetRotation().Equals(CurrentTM.GetRotation(), 1.e-4f));
+		TestTrue(FString::Printf(TEXT("Case %d: scale"), CaseIndex), PreviousTM.GetScale3D().Equals(CurrentTM.GetScale3D(), 1.e-4f));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSPWVirtualBonesPoseTest, "SimpleProceduralWalk.VirtualBones.PoseOutput", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+/*
+ * The tip bones moved on a component space pose (two legs, built from a test skeleton) match the previous world space round trip,
+ * for the tip bones and their children. Legs removed by LOD (INDEX_NONE) are left untouched.
+ */
+bool FSPWVirtualBonesPoseTest::RunTest(const FString& Parameters)
+{
+	// root, pelvis, then thigh, calf, foot & toe per leg
+	USkeleton* Skeleton = NewObject<USkeleton>(GetTransientPackage());
+	{
+		FReferenceSkeletonModifier Modifier(Skeleton);
+		Modifier.Add(FMeshBoneInfo(TEXT("root"), TEXT("root"), INDEX_NONE), FTransform::Identity);
+		Modifier.Add(FMeshBoneInfo(TEXT("pelvis"), TEXT("pelvis"), 0), FTransform(FVector(0.f, 0.f, 90.f)));
+		for (const float Side : { -1.f, 1.f })
+		{
+			const int32 ThighIndex = Skeleton->GetReferenceSkeleton().GetRawBoneNum();
+			const FString Prefix = Side < 0.f ? TEXT("l_") : TEXT("r_");
+			Modifier.Add(FMeshBoneInfo(*(Prefix + TEXT("thigh")), Prefix + TEXT("thigh"), 1), FTransform(FRotator(0.f, 0.f, 5.f * Side), FVector(0.f, 15.f * Side, -5.f)));
+			Modifier.Add(FMeshBoneInfo(*(Prefix + TEXT("calf")), Prefix + TEXT("calf"), ThighIndex), FTransform(FRotator(10.f, 0.f, 0.f), FVector(0.f, 0.f, -40.f)));
+			Modifier.Add(FMeshBoneInfo(*(Prefix + TEXT("foot")), Prefix + TEXT("foot"), ThighIndex + 1), FTransform(FRotator(-10.f, 0.f, 0.f), FVector(0.f, 0.f, -40.f)));
+			Modifier.Add(FMeshBoneInfo(*(Prefix + TEXT("toe")), Prefix + TEXT("toe"), ThighIndex + 2), FTransform(FVector(15.f, 0.f, -5.f)));
+		}
+	}
+
+	const FReferenceSkeleton& RefSkeleton = Skeleton->GetReferenceSkeleton();
+	TArray<FBoneIndexType> RequiredBones;
+	for (int32 BoneIndex = 0; BoneIndex < RefSkeleton.GetNum(); BoneIndex++)
+	{
+		RequiredBones.Add(static_cast<FBoneIndexType>(BoneIndex));
+	}
+	FBoneContainer BoneContainer(RequiredBones, FCurveEvaluationOption(false), *Skeleton);
+
+	// (all bones required, compact pose indices are the skeleton indices)
+	const FCompactPoseBoneIndex TipBones[] = { FCompactPoseBoneIndex(RefSkeleton.FindBoneIndex(TEXT("l_foot"))), FCompactPoseBoneIndex(RefSkeleton.FindBoneIndex(TEXT("r_foot"))) };
+	const FCompactPoseBoneIndex ChildBones[] = { FCompactPoseBoneIndex(RefSkeleton.FindBoneIndex(TEXT("l_toe"))), FCompactPoseBoneIndex(RefSkeleton.FindBoneIndex(TEXT("r_toe"))) };
+
+	FCompactPose RefPose;
+	RefPose.SetBoneContainer(&BoneContainer);
+	RefPose.ResetToRefPose();
+
+	FRandomStream Random(1234);
+	TArray<FBoneTransform> TipBoneTransforms;
+
+	for (int32 CaseIndex = 0; CaseIndex < 32; CaseIndex++)
+	{
+		const FTransform ComponentTransform(
+			FRotator(Random.FRandRange(-30.f, 30.f), Random.FRandRange(-180.f, 180.f), Random.FRandRange(-30.f, 30.f))
+			, Random.GetUnitVector() * Random.FRandRange(0.f, 10000.f)
+			, FVector(Random.FRandRange(.5f, 2.f)));
+
+		FVector FootLocations[2];
+		FQuat FootTargetRotations[2];
+		for (int32 LegIndex = 0; LegIndex < 2; LegIndex++)
+		{
+			FootLocations[LegIndex] = ComponentTransform.GetLocation() + Random.GetUnitVector() * Random.FRandRange(0.f, 100.f);
+			FootTargetRotations[LegIndex] = FRotator(Random.FRandRange(-30.f, 30.f), 0.f, Random.FRandRange(-30.f, 30.f)).Quaternion();
+		}
+
+		// every other case, the right leg is removed by LOD
+		const bool bIsRightLegRemoved = CaseIndex % 2 == 1;
+		const FCompactPoseBoneIndex TipBoneIndices[] = { TipBones[0], bIsRightLegRemoved ? FCompactPoseBoneIndex(INDEX_NONE) : TipBones[1] };
+
+		// node path
+		FCSPose<FCompactPose> Pose;
+		Pose.InitPose(RefPose);
+		SimpleProceduralWalk_VirtualBones::TransformTipBones(Pose, ComponentTransform, TipBoneIndices, FootLocations, FootTargetRotations, 1.f, TipBoneTransforms);
+
+		// previous path: world space round trip, one leg at a time
+		FCSPose<FCompactPose> PreviousPose;
+		PreviousPose.InitPose(RefPose);
+		for (int32 LegIndex = 0; LegIndex < 2; LegIndex++)
+		{
+			if (TipBoneIndices[LegIndex].GetInt() == INDEX_NONE)
+			{
+				continue;
+			}
+
+			FTransform PreviousTM = PreviousPose.GetComponentSpaceTransform(TipBoneIndices[LegIndex]);
+			FAnimationRuntime::ConvertCSTransformToBoneSpace(ComponentTransform, PreviousPose, PreviousTM, TipBoneIndices[LegIndex], BCS_WorldSpace);
+			PreviousTM.SetTranslation(FootLocations[LegIndex]);
+			FAnimationRuntime::ConvertBoneSpaceTransformToCS(ComponentTransform, PreviousPose, PreviousTM, TipBoneIndices[LegIndex], BCS_WorldSpace);
+			PreviousTM.SetRotation(FootTargetRotations[LegIndex] * PreviousTM.GetRotation());
+
+			TArray<FBoneTransform> PreviousBoneTransforms;
+			PreviousBoneTransforms.Add(FBoneTransform(TipBoneIndices[LegIndex], PreviousTM));
+			PreviousPose.LocalBlendCSBoneTransforms(PreviousBoneTransforms, 1.f);
+		}
+
+		for (int32 LegIndex = 0; LegIndex < 2; LegIndex++)
+		{
+			for (const FCompactPoseBoneIndex BoneIndex : { TipBones[LegIndex], ChildBones[LegIndex] })
+			{
+				const FTransform& CurrentTM = Pose.GetComponentSpaceTransform(BoneIndex);
+				const FTransform& PreviousTM = PreviousPose.GetComponentSpaceTransform(BoneIndex);
+				const FString What = FString::Printf(TEXT("Case %d, bone %s"), CaseIndex, *RefSkeleton.GetBoneName(BoneIndex.GetInt()).ToString());
+
+				TestTrue(What + TEXT(": translation"), PreviousTM.GetTranslation().Equals(CurrentTM.GetTranslation(), .05f));
+				TestTrue(What + TEXT(": rotation"), PreviousTM.GetRotation().Equals(CurrentTM.GetRotation(), 1.e-4f));
+			}
+		}
+
+		// removed leg, untouched
+		if (bIsRightLegRemoved)
+		{
+			TestTrue(FString::Printf(TEXT("Case %d: removed leg"), CaseIndex), Pose.GetComponentSpaceTransform(TipBones[1]).Equals(PreviousPose.GetComponentSpaceTransform(TipBones[1]), 1.e-4f)
+				&& Pose.GetLocalSpaceTransform(TipBones[1]).Equals(RefPose[TipBones[1]], 1.e-4f));
+		}
+	}
+
+	return true;
+}
+
+#endif
@@ -5,10 +5,14 @@
 #include "CoreMinimal.h"
 #include "SPW.h"
 #include "SPW_CCDIKSolver.h"
+#include "SPWWalkProfile.h"
 #include "Curves/CurveFloat.h"
+#include "CollisionQueryParams.h"
 #include "BoneControllers/AnimNode_SkeletalControlBase.h"
 #include "AnimNode_SPW.generated.h"
 
+class USkinnedMeshComponent;
+class UBlendSpace;
 
 USTRUCT()
 struct SIMPLEPROCEDURALWALK_API FAnimNode_SPW : public FAnimNode_SkeletalControlBase
@@ -29,6 +33,13 @@ public:
 	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Simple Procedural Walk")
 		bool bDetectFalling = true;
 
+	/**
+	 * Walk settings shared with other nodes.
+	 * When set, the profile's Walk Cycle, Step Control, Body Rotation, Solver, IK precision and Trace settings are used instead of this node's.
+	 */
+	UPROPERTY(EditAnywhere, Category = "Simple Procedural Walk")
+		USPWWalkProfile* WalkProfile = nullptr;
+
 	// ---------- \/ Skeletal Control ----------
 	/**
 	 * The forward axis of the Skeletal Mesh.
@@ -149,6 +160,13 @@ public:
 	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Body Rotation", meta = (ClampMin = "0.0", EditCondition = "bBodyRotateOnFeetLocations"))
 		float BodyFeetLocationsRotationMultiplier = 0.f;
 
+	/**
+	 * Compute the body rotation from a least-squares plane fit over all feet targets, instead of the forward / backwards / right / left averages.
+	 * More robust with asymmetric leg layouts, and with legs close to the center lines.
+	 */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Body Rotation", meta = (EditCondition = "bBodyRotateOnFeetLocations"))
+		bool bBodyRotateOnFeetPlane = false;
+
 	/** Maximum body rotation, per axis: Roll (X), Pitch (Y), and Yaw (Z, ignored). */
 	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Body Rotation", meta = (ClampMin = "0.0", EditCondition = "bBodyRotateOnAcceleration || bBodyRotateOnFeetLocations"))
 		FRotator MaxBodyRotation = FRotator(0.f);
@@ -173,6 +191,17 @@ public:
 	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Solver", meta = (ClampMin = "1.0", ClampMax = "3.0", EditCondition = "SolverType == ESimpleProceduralWalk_SolverType::ADVANCED"))
 		float DistanceCheckMultiplier = 0.f;
 
+	/**
+	 * Updates longer than this (for instance with Update Rate Optimizations or the Animation Budget Allocator) are split into sub-steps,
+	 * so that steps and interpolations behave as when updated every frame (0 disables sub-stepping).
+	 */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Solver", meta = (ClampMin = "0.0"))
+		float MaxSubstepDeltaTime = 0.f;
+
+	/** Maximum number of sub-steps per update. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Solver", meta = (ClampMin = "1"))
+		int32 MaxSubsteps = 1;
+
 	// ---------- \/ IK Solver ----------
 	/**
 	 * Set to true to use Simple Procedural Walk's internal CCDIK.
@@ -193,6 +222,45 @@ public:
 	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "IK Solver", meta = (ClampMin = "0", EditCondition = "bEnableIkSolver"))
 		int32 MaxIterations = 0;
 
+	/**
+	 * Solve legs in batches of 4, one leg per SIMD lane.
+	 * Legs that cannot be vectorized (for instance chains containing Virtual Bones) fall back to the per-leg solver.
+	 */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "IK Solver", meta = (EditCondition = "bEnableIkSolver"))
+		bool bVectorizedSolver = true;
+
+	/** Reuse the previous solution of a leg when its target, its input pose and the body did not change. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "IK Solver", meta = (EditCondition = "bEnableIkSolver"))
+		bool bCacheSolvedLegs = true;
+
+	/** Tolerance used to consider the target, the input pose and the body unchanged. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "IK Solver", meta = (ClampMin = "0.0", EditCondition = "bEnableIkSolver && bCacheSolvedLegs"))
+		float CacheTolerance = 0.f;
+
+	/** Scale the precision and the maximum number of iterations of each leg with the distance from the camera. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "IK Solver", meta = (EditCondition = "bEnableIkSolver"))
+		bool bAdaptiveIterations = false;
+
+	/** Up to this distance from the camera, Precision and Max Iterations are used. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "IK Solver", meta = (ClampMin = "0.0", EditCondition = "bEnableIkSolver && bAdaptiveIterations"))
+		float AdaptiveNearDistance = 0.f;
+
+	/** From this distance from the camera, Far Precision and Far Max Iterations are used. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "IK Solver", meta = (ClampMin = "0.0", EditCondition = "bEnableIkSolver && bAdaptiveIterations"))
+		float AdaptiveFarDistance = 0.f;
+
+	/** Tolerance for final tip bone location delta of distant legs, and of legs solved after the time budget is spent. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "IK Solver", meta = (ClampMin = "0.0", EditCondition = "bEnableIkSolver && bAdaptiveIterations"))
+		float FarPrecision = 0.f;
+
+	/** Maximum number of iterations of distant legs, and of legs solved after the time budget is spent. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "IK Solver", meta = (ClampMin = "0", EditCondition = "bEnableIkSolver && bAdaptiveIterations"))
+		int32 FarMaxIterations = 0;
+
+	/** Time allowed to solve all legs, per frame, in microseconds (0 means no limit). */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "IK Solver", meta = (ClampMin = "0.0", EditCondition = "bEnableIkSolver && bAdaptiveIterations"))
+		float TimeBudgetMicroseconds = 0.f;
+
 	// ---------- \/ Trace ----------
 	/**
 	 * The trace channel.
@@ -213,6 +281,115 @@ public:
 	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Trace")
 		float TraceZOffset = 0.f;
 
+	/**
+	 * Update after the skinned meshes the feet are planted on (for instance tracked hands),
+	 * so that feet follow the bones of the same frame instead of the previous one.
+	 */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Trace")
+		bool bTickAfterSkinnedSupports = false;
+
+	// ---------- \/ Quality Tiers ----------
+	/**
+	 * Reduce the work done for less significant walkers:
+	 * Full: full quality.
+	 * Reduced: BASIC solver, feet traced every few frames.
+	 * Body Only: no traces nor steps, feet are interpolated under the body.
+	 * Frozen: no computations, the procedural pose is faded out (to the baked gait, if any).
+	 */
+	UPROPERTY(EditAnywhere, Category = "Quality Tiers")
+		bool bEnableQualityTiers = false;
+
+	/**
+	 * The significance of the walker, for instance from the Significance Manager.
+	 * Negative values compute it from the visibility and the screen size of the mesh, seen from the closest local camera.
+	 */
+	UPROPERTY(EditAnywhere, Category = "Quality Tiers", meta = (PinHiddenByDefault, EditCondition = "bEnableQualityTiers"))
+		float Significance = -1.f;
+
+	/** Below this significance, the Reduced tier is used. */
+	UPROPERTY(EditAnywhere, Category = "Quality Tiers", meta = (ClampMin = "0.0", EditCondition = "bEnableQualityTiers"))
+		float ReducedSignificance = 0.f;
+
+	/** Below this significance, the Body Only tier is used. */
+	UPROPERTY(EditAnywhere, Category = "Quality Tiers", meta = (ClampMin = "0.0", EditCondition = "bEnableQualityTiers"))
+		float BodyOnlySignificance = 0.f;
+
+	/** Below this significance, the Frozen tier is used. */
+	UPROPERTY(EditAnywhere, Category = "Quality Tiers", meta = (ClampMin = "0.0", EditCondition = "bEnableQualityTiers"))
+		float FrozenSignificance = 0.f;
+
+	/** How much higher (in percentage of the threshold) should the significance be before going back to a better tier. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Quality Tiers", meta = (ClampMin = "0.0", EditCondition = "bEnableQualityTiers"))
+		float SignificanceHysteresis = 0.f;
+
+	/** In the Reduced tier, each foot is traced once every this number of frames. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Quality Tiers", meta = (ClampMin = "1", EditCondition = "bEnableQualityTiers"))
+		int32 ReducedTraceInterval = 1;
+
+	/** The time it takes to fade the procedural pose in or out of the Frozen tier. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Quality Tiers", meta = (ClampMin = "0.0", EditCondition = "bEnableQualityTiers"))
+		float TierBlendTime = 0.f;
+
+	/**
+	 * A blend space baked with the Gait Baker (Direction & Speed axes), played in the Frozen tier instead of the input pose.
+	 * It starts at the gait phase of the walker, so that feet do not jump when the procedural pose fades out.
+	 */
+	UPROPERTY(EditAnywhere, Category = "Quality Tiers", meta = (EditCondition = "bEnableQualityTiers"))
+		UBlendSpace* BakedGaitBlendSpace = nullptr;
+
+	/** The number of walk cycles in each sequence of the baked blend space (as set when baking). */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Quality Tiers", meta = (ClampMin = "1", EditCondition = "bEnableQualityTiers"))
+		int32 BakedGaitCycles = 0;
+
+	// ---------- \/ Off Screen ----------
+	/**
+	 * While the mesh is not rendered, keep the walk cycle going without traces: feet targets are computed from the movement.
+	 * Feet are traced again when the mesh is rendered. IK is not solved while the mesh is not rendered.
+	 */
+	UPROPERTY(EditAnywhere, Category = "Off Screen")
+		bool bEnableOffScreenMode = false;
+
+	/** Should the step events (for instance for footstep sounds) be raised while off screen? */
+	UPROPERTY(EditAnywhere, Category = "Off Screen", meta = (EditCondition = "bEnableOffScreenMode"))
+		bool bRaiseStepEventsOffScreen = false;
+
+	// ---------- \/ Sleep ----------
+	/**
+	 * Suspend traces and solving while the pawn stands still, with all feet planted on supports that do not move.
+	 * The walker wakes up when the pawn or a support moves.
+	 */
+	UPROPERTY(EditAnywhere, Category = "Sleep")
+		bool bEnableSleep = false;
+
+	/** How long should the pawn stand still before going to sleep. */
+	UPROPERTY(EditAnywhere, Category = "Sleep", meta = (ClampMin = "0.0", EditCondition = "bEnableSleep"))
+		float SleepDelay = 0.f;
+
+	/** While true, the walker does not go to sleep (and wakes up if sleeping). Expose it as a pin to wake up the walker from gameplay. */
+	UPROPERTY(EditAnywhere, Category = "Sleep", meta = (PinHiddenByDefault, EditCondition = "bEnableSleep"))
+		bool bKeepAwake = false;
+
+	// ---------- \/ Pose Sharing ----------
+	/**
+	 * Distant walkers with the same skeleton and Walk Profile copy the feet & body of a nearby template walker (with a phase offset),
+	 * instead of tracing and computing their own. Feet are adapted to the ground height of each walker with a single trace.
+	 * Clones with the same mesh & LOD as their template also copy its solved bones, and skip the body & IK solvers.
+	 */
+	UPROPERTY(EditAnywhere, Category = "Pose Sharing")
+		bool bEnablePoseSharing = false;
+
+	/** Below this significance, the walker copies the pose of a template walker (uses the Quality Tiers significance). */
+	UPROPERTY(EditAnywhere, Category = "Pose Sharing", meta = (ClampMin = "0.0", EditCondition = "bEnablePoseSharing"))
+		float PoseSharingSignificance = 0.f;
+
+	/** The maximum number of walkers copying the pose of the same template walker. */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Pose Sharing", meta = (ClampMin = "1", EditCondition = "bEnablePoseSharing"))
+		int32 MaxClonesPerTemplate = 1;
+
+	/** The maximum distance between a walker and the template walker it copies (0 for no limit). */
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Pose Sharing", meta = (ClampMin = "0.0", EditCondition = "bEnablePoseSharing"))
+		float PoseSharingMaxDistance = 0.f;
+
 public:
 	// Constructor
 	FAnimNode_SPW();
@@ -220,6 +397,8 @@ public:
 	// FAnimNode_Base interface
 	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
 	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual bool HasPreUpdate() const override { return true; }
+	virtual void PreUpdate(const UAnimInstance* InAnimInstance) override;
 
 	// FAnimNode_SkeletalControlBase interface
 	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
@@ -230,6 +409,9 @@ public:
 	// from graph node: resize rotation limit array based on set up
 	void CCDIK_ResizeRotationLimitPerJoints(int32 LegIndex, int32 NewSize);
 
+	// normalized phase of the walk cycle: 0 when the first group unplants, then the step progress of each group in sequence
+	float GetGaitPhase() const;
+
 private:
 	// internals
 	bool bHasErrors = false;
@@ -240,11 +422,10 @@ private:
 	float WorldDeltaSeconds = 0.f;
 
 	// References
-	UPROPERTY()
-	UWorld* WorldContext = nullptr;
-	UPROPERTY()
-	USkeletalMeshComponent* SkeletalMeshComponent = nullptr;
-	UPROPERTY()
+	// Runtime state is not reflected, so the garbage collector does not scan it.
+	// Objects are held weakly: they are read on the anim worker, and can be destroyed between frames.
+	TWeakObjectPtr<UWorld> WorldContext;
+	TWeakObjectPtr<USkeletalMeshComponent> SkeletalMeshComponent;
 	TArray<FName> VirtualBoneNames;
 
 	// pawn
@@ -263,52 +444,100 @@ private:
 	float CurrentStepDuration = 0.f;
 
 	// pawn data
-	UPROPERTY()
-	APawn* OwnerPawn = nullptr;
+	TWeakObjectPtr<APawn> OwnerPawn;
 	bool bIsPawnClass;
 	float OwnerHalfHeight;
 	FVector MeshScale;
 	float MeshAverageScale;
 
+	// trace scratch (kept between frames to avoid allocations)
+	// ignored actors are resolved on the game thread, before each update
+	FCollisionQueryParams TraceQueryParams;
+	TArray<FHitResult> FootHoldHits;
+
+	// skinned mesh supports this mesh ticks after
+	TArray<TWeakObjectPtr<USkinnedMeshComponent>> TickPrerequisiteSupports;
+	void UpdateSupportTickPrerequisites();
+	void SetSupportTickPrerequisite(TWeakObjectPtr<USkinnedMeshComponent> SupportComp, bool bIsPrerequisite);
+
 	// legs
-	UPROPERTY()
-	TArray<FSimpleProceduralWalk_LegData> LegsData;
+	FSimpleProceduralWalk_LegsData LegsData;
 
 	// groups
 	int32 CurrentGroupIndex = 0;
-	UPROPERTY()
 	TArray<FSimpleProceduralWalk_LegGroupData> GroupsData;
 
 	// body
-	FRotator CurrentBodyRelRotation = FRotator(0.f);
+	FQuat CurrentBodyRelRotation = FQuat::Identity;
+	FQuat CurrentBodyBoneRotation = FQuat::Identity;
 	FVector CurrentBodyRelLocation = FVector(0.f);
 	float ReduceSlopeMultiplierPitch = 1.f;
 	float ReduceSlopeMultiplierRoll = 1.f;
 
 	// IK
-	UPROPERTY()
 	TArray<FBoneSocketTarget> EffectorTargets;
-	UPROPERTY()
 	TArray<FBoneReference> ParentBones;
-	UPROPERTY()
 	TArray<FBoneReference> TipBones;
-	UPROPERTY()
+	// rotation limits of the bones kept by the LOD, in radians
 	TArray<FSimpleProceduralWalk_RotationLimitsPerJoint> FeetRotationLimitsPerJoints;
-
-	// step
-	void CreateDefaultCurves();
-	FRichCurve StepHeightCurveRobot;
-	FRichCurve StepDistanceCurveRobot;
-	FRichCurve StepHeightCurveOrganic;
-	FRichCurve StepDistanceCurveOrganic;
+	TArray<bool> LegsChainValid;
+	int32 GetLODBoneIndex(const FBoneContainer& RequiredBones, int32 MeshBoneIndex) const;
+
+	// bone validation (cached per bone container)
+	bool bIsBoneValidationCached = false;
+	bool bAreBonesValidToEvaluate = false;
+	uint16 ValidatedBoneContainerSerial = 0;
+	TBitArray<> VirtualBonesMask;
+	bool AreBonesValidToEvaluate(const FBoneContainer& RequiredBones);
+
+	// profile & step curves (shared, read-only)
+	const FSimpleProceduralWalk_StepCurves* StepCurves = nullptr;
+	TSharedPtr<FSimpleProceduralWalk_StepCurves> CustomStepCurves;
+	void ApplyWalkProfile();
+
+	// settings read from the Walk Profile if any (never copied to the node), otherwise from the node
+	FORCEINLINE float GetMinDistanceToUnplant() const { return WalkProfile != nullptr ? WalkProfile->MinDistanceToUnplant : MinDistanceToUnplant; }
+	FORCEINLINE float GetFixFeetTargetsAfterPercent() const { return WalkProfile != nullptr ? WalkProfile->FixFeetTargetsAfterPercent : FixFeetTargetsAfterPercent; }
+	FORCEINLINE float GetFeetTipBonesRotationInterpSpeed() const { return WalkProfile != nullptr ? WalkProfile->FeetTipBonesRotationInterpSpeed : FeetTipBonesRotationInterpSpeed; }
+	FORCEINLINE float GetStepSlopeReductionMultiplier() const { return WalkProfile != nullptr ? WalkProfile->StepSlopeReductionMultiplier : StepSlopeReductionMultiplier; }
+	FORCEINLINE float GetMinStepDuration() const { return WalkProfile != nullptr ? WalkProfile->MinStepDuration : MinStepDuration; }
+	FORCEINLINE float GetBodyAccelerationRotationMultiplier() const { return WalkProfile != nullptr ? WalkProfile->BodyAccelerationRotationMultiplier : BodyAccelerationRotationMultiplier; }
+	FORCEINLINE float GetBodyFeetLocationsRotationMultiplier() const { return WalkProfile != nullptr ? WalkProfile->BodyFeetLocationsRotationMultiplier : BodyFeetLocationsRotationMultiplier; }
+	FORCEINLINE const FRotator& GetMaxBodyRotation() const { return WalkProfile != nullptr ? WalkProfile->MaxBodyRotation : MaxBodyRotation; }
+	FORCEINLINE ESimpleProceduralWalk_SolverType GetSolverType() const { return WalkProfile != nullptr ? WalkProfile->SolverType : SolverType; }
+	FORCEINLINE float GetFeetInAirInterSpeed() const { return WalkProfile != nullptr ? WalkProfile->FeetInAirInterSpeed : FeetInAirInterSpeed; }
+	FORCEINLINE float GetRadiusCheckMultiplier() const { return WalkProfile != nullptr ? WalkProfile->RadiusCheckMultiplier : RadiusCheckMultiplier; }
+	FORCEINLINE float GetDistanceCheckMultiplier() const { return WalkProfile != nullptr ? WalkProfile->DistanceCheckMultiplier : DistanceCheckMultiplier; }
+	FORCEINLINE float GetPrecision() const { return WalkProfile != nullptr ? WalkProfile->Precision : Precision; }
+	FORCEINLINE int32 GetMaxIterations() const { return WalkProfile != nullptr ? WalkProfile->MaxIterations : MaxIterations; }
+	FORCEINLINE ETraceTypeQuery GetTraceChannel() const { return WalkProfile != nullptr ? WalkProfile->TraceChannel : TraceChannel; }
+	FORCEINLINE float GetTraceLength() const { return WalkProfile != nullptr ? WalkProfile->TraceLength : TraceLength; }
+	FORCEINLINE bool ShouldTraceComplex() const { return WalkProfile != nullptr ? WalkProfile->bTraceComplex : bTraceComplex; }
+	FORCEINLINE float GetTraceZOffset() const { return WalkProfile != nullptr ? WalkProfile->TraceZOffset : TraceZOffset; }
+#if WITH_EDITOR
+	void UpdateStepCurves();
+#endif
 
 	// ---------- \/ computations ----------
+	// evaluation policies
+	typedef void (FAnimNode_SPW::*FSetFeetTargetLocationsFunction)();
+	FSetFeetTargetLocationsFunction SetFeetTargetLocationsFunction = nullptr;
+	bool bIsDebugDrawEnabled = false;
+	FVector SettingsScale = FVector(1.f);
+	float SettingsAverageScale = 1.f;
+	void SelectEvaluationPolicies();
+
 	void Initialize_Computations(const FAnimationInitializeContext& Context);
 	void Evaluate_Computations();
 	void UpdatePawnVariables();
 	void SetSupportCompDeltas();
+	int32 GetNumSubsteps() const;
 	// walk
 	void SetFeetTargetLocations();
+	void SetOffScreenFeetTargetLocations();
+	template<ESimpleProceduralWalk_SolverType InSolverType, bool bInDebug>
+	void SetFeetTargetLocationsWithPolicy();
+	template<ESimpleProceduralWalk_SolverType InSolverType, bool bInDebug>
 	void SetFootTargetLocation(int32 LegIndex);
 	void SetCurrentGroupUnplanted();
 	void ComputeFeet();
@@ -316,7 +545,8 @@ private:
 	void ResetFeetTargetsAndLocations();
 	// body
 	void ComputeBodyTransform();
-	void ComputeBodyRotation(FVector AverageFeetTargetsForward
+	void ComputeBodyRotation(const TSimpleProceduralWalk_LegArray<FVector>& FeetRelTargets
+		, FVector AverageFeetTargetsForward
 		, FVector AverageFeetTargetsBackwards
 		, FVector AverageFeetTargetsRight
 		, FVector AverageFeetTargetsLeft);
@@ -324,14 +554,27 @@ private:
 		, FVector AverageFeetTargetsBackwards
 		, FVector AverageFeetTargetsRight
 		, FVector AverageFeetTargetsLeft);
-	void GetAverageFeetTargets(FVector* AverageFeetTargetsForward
+	void GetAverageFeetTargets(const TSimpleProceduralWalk_LegArray<FVector>& FeetRelTargets
+		, FVector* AverageFeetTargetsForward
 		, FVector* AverageFeetTargetsBackwards
 		, FVector* AverageFeetTargetsRight
 		, FVector* AverageFeetTargetsLeft);
 
 	// ix
+	// step events are queued during the update, and raised on the game thread before the next one
+	struct FStepEvent
+	{
+		bool bIsDown;
+		bool bIsGroup;
+		int32 Index;
+		FName BoneName;
+		FVector Location;
+		FHitResult Hit;
+	};
+	TArray<FStepEvent> StepEvents;
 	void CallStepInterfaces(int32 GroupIndex, bool bIsDown);
-	void CallStepInterface(UObject* InterfaceOwner, int32 GroupIndex, bool bIsDown);
+	void FlushStepEvents();
+	void FlushStepEvents(UObject* InterfaceOwner);
 	void CallLandedInterfaces();
 	void CallLandedInterface(UObject* InterfaceOwner);
 
@@ -348,7 +591,7 @@ private:
 	bool IsFalling();
 
 	// scale
-	FVector GetScaledLegOffset(FSimpleProceduralWalk_Leg Leg);
+	FVector GetScaledLegOffset(const FSimpleProceduralWalk_Leg& Leg);
 	float GetScaledStepHeight();
 	float GetScaledStepDistanceForward();
 	float GetScaledStepDistanceRight();
@@ -358,19 +601,106 @@ private:
 	float GetScaledMinStepDuration();
 	float GetAdaptedMinDistanceToUnplant(int32 LegIndex);
 
+	// quality tiers
+	ESimpleProceduralWalk_QualityTier CurrentQualityTier = ESimpleProceduralWalk_QualityTier::FULL;
+	float QualityTierBlendWeight = 1.f;
+	float CurrentSignificance = 1.f;
+	int32 TraceInterval = 1;
+	uint32 TraceFrame = 0;
+	float LastUpdateTime = -1.f;
+	bool bIsOffScreen = false;
+	int32 GovernorLevel = 0;
+	bool bIsBasicSolverForced = false;
+	bool bIsTraceComplex = false;
+	float TraceLengthScale = 1.f;
+	// closest local player camera (-1 if none), updated once per update
+	float ViewDistance = -1.f;
+	float ViewScreenSize = -1.f;
+	// local player cameras & visibility, gathered on the game thread before the update
+	struct FViewPoint
+	{
+		FVector Location;
+		float HalfFOVTangent;
+	};
+	TArray<FViewPoint, TInlineAllocator<4>> ViewPoints;
+	FBoxSphereBounds ViewBounds;
+	bool bWasRecentlyRendered = true;
+	void GatherViews(const USkeletalMeshComponent* InSkeletalMeshComponent);
+	void UpdateView();
+	void UpdateScalability();
+	void UpdateGovernor();
+	void UpdateOffScreen();
+	void UpdateQualityTier();
+	// baked gait (frozen tier)
+	bool bIsBakedGaitPlaying = false;
+	float BakedGaitPhase = 0.f;
+	TArray<FBlendSampleData> BakedGaitSamples;
+	void UpdateBakedGait();
+	void Evaluate_BakedGait(FComponentSpacePoseContext& Output);
+	float ComputeSignificance();
+	void SetQualityTier(ESimpleProceduralWalk_QualityTier NewQualityTier);
+	void ComputeFeetAtRest();
+
+	// sleep
+	bool bIsAsleep = false;
+	float StillTime = 0.f;
+	FVector SleepActorLocation = FVector(0.f);
+	FQuat SleepActorRotation = FQuat::Identity;
+	// incoming pose of the body & tip bones (before the solvers)
+	TSimpleProceduralWalk_LegArray<FTransform> SleepInputTransforms;
+	bool bIsSleepInputPoseChanged = false;
+	void UpdateSleep();
+	bool ShouldWakeUp();
+	void WakeUp();
+	void Evaluate_SleepInputPose(FComponentSpacePoseContext& Output);
+
+	// pose sharing
+	bool bIsPoseClone = false;
+	bool bIsPoseTemplate = false;
+	uint64 PoseRegisterFrame = 0;
+	TWeakObjectPtr<const USkeletalMeshComponent> PoseTemplateComponent;
+	// template: filled, then swapped with the oldest snapshot of its history (no allocation while clones let go of it)
+	FSimpleProceduralWalk_PoseSnapshotPtr TemplatePoseSnapshot;
+	// clone: the snapshot of its template (shared, read only)
+	FSimpleProceduralWalk_PoseSnapshotConstPtr ClonePoseSnapshot;
+	float CloneGroundOffset = 0.f;
+	FVector CloneCSGroundOffset = FVector(0.f);
+	int32 ClonePhaseDelay = 0;
+	TArray<FBoneTransform> CloneBoneTransforms;
+	void UpdatePoseSharing();
+	void ComputeFromTemplate();
+	void PublishPose();
+	void RecordSolvedBones(FComponentSpacePoseContext& Output);
+	bool ApplyTemplateBones(FComponentSpacePoseContext& Output);
+
 	// debug
 	void DebugShow();
 	void EditorDebugShow(AActor* SkeletalMeshOwner);
 
 	// BODY
+	TArray<FBoneTransform> BodyBoneTransforms;
 	void Evaluate_BodySolver(FComponentSpacePoseContext& Output);
 
 	// solver
 	float RadiusCheck;
 
 	// CCDIK
+	TArray<FSPW_CCDIKLegChain> CCDIKLegChains;
+	TArray<FSPW_CCDIKLinkLanes> CCDIKLinkLanes;
+	uint32 CCDIKCacheHits = 0;
+	uint32 CCDIKCacheMisses = 0;
 	void Initialize_CCDIK();
+	void CCDIK_RemapRotationLimits(int32 LegIndex, const FBoneContainer& RequiredBones);
 	void Evaluate_CCDIKSolver(FComponentSpacePoseContext& Output);
+	void CCDIK_GatherChain(FComponentSpacePoseContext& Output, int32 LegIndex);
+	void CCDIK_ApplyChain(FComponentSpacePoseContext& Output, int32 LegIndex);
+	bool CCDIK_CanSolveInLanes(int32 LegIndex);
+	bool CCDIK_IsCachedSolutionValid(int32 LegIndex);
+	bool CCDIK_IsOverTimeBudget(uint32 StartCycles);
+	void CCDIK_SetLegSolverSettings(int32 LegIndex, bool bIsOverTimeBudget);
+	void CCDIK_SetCachedSolutionInputs(int32 LegIndex);
+	void CCDIK_SolveLanes(const int32* LaneLegIndices, int32 NumLanes, uint32 SolveStartCycles);
+	void SolveCCDIKLanes(const int32* LaneLegIndices, int32 NumLanes);
 	FTransform CCDIK_GetTargetTransform(const FTransform& InComponentTransform
 		, FCSPose<FCompactPose>& MeshBases
 		, FBoneSocketTarget& InTarget
@@ -379,7 +709,13 @@ private:
 	bool SolveCCDIK(TArray<FSPW_CCDIKChainLink>& InOutChain
 		, const FVector& TargetPosition
 		, bool bEnableRotationLimit
-		, const TArray<float>& RotationLimitPerJoints);
-
+		, const TArray<float>& RotationLimitPerJoints
+		, float InPrecision
+		, int32 InMaxIterations
+		, int32& OutIterations
+		, float& OutResidualError);
+
+	// virtual bones
+	TArray<FBoneTransform> TipBoneTransforms;
 	void Evaluate_TransformBones(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms);
 };
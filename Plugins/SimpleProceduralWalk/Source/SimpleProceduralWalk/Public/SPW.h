@@ -4,11 +4,30 @@
 
 #include "CoreMinimal.h"
 #include "BoneContainer.h"
+#include "BonePose.h"
+#include "Stats/Stats.h"
+#include "Curves/RichCurve.h"
 #include "Kismet/KismetSystemLibrary.h"
 #include "SPW.generated.h"
 
+class UPrimitiveComponent;
+class UPhysicalMaterial;
+
 DECLARE_LOG_CATEGORY_EXTERN(LogSimpleProceduralWalk, Log, All);
 
+// stats
+DECLARE_STATS_GROUP(TEXT("Simple Procedural Walk"), STATGROUP_SimpleProceduralWalk, STATCAT_Advanced);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Computations"), STAT_SPW_Computations, STATGROUP_SimpleProceduralWalk, SIMPLEPROCEDURALWALK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Feet Targets"), STAT_SPW_FeetTargets, STATGROUP_SimpleProceduralWalk, SIMPLEPROCEDURALWALK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Body Solver"), STAT_SPW_BodySolver, STATGROUP_SimpleProceduralWalk, SIMPLEPROCEDURALWALK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CCDIK Solver"), STAT_SPW_CCDIKSolver, STATGROUP_SimpleProceduralWalk, SIMPLEPROCEDURALWALK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Virtual Bones"), STAT_SPW_VirtualBones, STATGROUP_SimpleProceduralWalk, SIMPLEPROCEDURALWALK_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CCDIK Solved Legs"), STAT_SPW_CCDIKSolvedLegs, STATGROUP_SimpleProceduralWalk, SIMPLEPROCEDURALWALK_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CCDIK Cached Legs"), STAT_SPW_CCDIKCachedLegs, STATGROUP_SimpleProceduralWalk, SIMPLEPROCEDURALWALK_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("CCDIK Iterations"), STAT_SPW_CCDIKIterations, STATGROUP_SimpleProceduralWalk, SIMPLEPROCEDURALWALK_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Governor Level"), STAT_SPW_GovernorLevel, STATGROUP_SimpleProceduralWalk, SIMPLEPROCEDURALWALK_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Governor Frame Time (ms)"), STAT_SPW_GovernorFrameTime, STATGROUP_SimpleProceduralWalk, SIMPLEPROCEDURALWALK_API);
+
 
 USTRUCT()
 struct SIMPLEPROCEDURALWALK_API FSimpleProceduralWalk_Leg
@@ -57,32 +76,251 @@ public:
 		TArray<float> RotationLimits;
 };
 
-USTRUCT()
-struct SIMPLEPROCEDURALWALK_API FSimpleProceduralWalk_LegData
+/** Number of legs stored inline (without heap allocations) in the per-leg runtime data. */
+#define SPW_INLINE_LEGS 8
+
+template<typename ElementType>
+using TSimpleProceduralWalk_LegArray = TArray<ElementType, TInlineAllocator<SPW_INLINE_LEGS>>;
+
+enum class ESimpleProceduralWalk_LegFlags : uint8
 {
-	GENERATED_USTRUCT_BODY()
+	None = 0,
+	Forward = 1 << 0,
+	Backwards = 1 << 1,
+	Right = 1 << 2,
+	Left = 1 << 3,
+	EnableIK = 1 << 4,
+};
+ENUM_CLASS_FLAGS(ESimpleProceduralWalk_LegFlags);
 
+/** The part of a foot trace hit that is kept between frames. */
+struct SIMPLEPROCEDURALWALK_API FSimpleProceduralWalk_LegHit
+{
 public:
-	FVector FootLocation = FVector(0.f);
-	FVector FootTarget = FVector(0.f);
-	FRotator FootTargetRotation = FRotator(0.f);
-	FVector FootUnplantLocation = FVector(0.f);
-	FVector TipBoneOriginalRelLocation = FVector(0.f);
-	int32 GroupIndex = 0.f;
-	bool bIsForward = false;
-	bool bIsBackwards = false;
-	bool bIsRight = false;
-	bool bIsLeft = false;
-	float Length = 0.f;
-	bool bEnableIK = false;
-	// support
-	UPROPERTY()
-	FHitResult LastHit;
-	UPROPERTY()
-	UPrimitiveComponent* SupportComp = nullptr;
-	FTransform SupportCompPreviousTransform = FTransform(FRotator(0.f), FVector(0.f), FVector(1.f));
-	FVector SupportCompDelta = FVector(0.f);
-	FVector RelLocationToSupportComp = FVector(0.f);
+	FVector ImpactPoint = FVector(0.f);
+	FVector ImpactNormal = FVector(0.f);
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+	FName BoneName = NAME_None;
+	TWeakObjectPtr<UPhysicalMaterial> PhysMaterial;
+	bool bBlockingHit = false;
+
+	void SetFromHitResult(const FHitResult& Hit);
+	FHitResult ToHitResult() const;
+};
+
+/** The component a foot is planted on. */
+struct SIMPLEPROCEDURALWALK_API FSimpleProceduralWalk_LegSupport
+{
+public:
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+	FName BoneName = NAME_None;
+	FTransform PreviousTransform = FTransform(FRotator(0.f), FVector(0.f), FVector(1.f));
+	FVector RelLocation = FVector(0.f);
+	/** Static components never move, so they never produce a delta. */
+	bool bIsStatic = false;
+	/** The bone of a skinned mesh support (such as a tracked hand), resolved once when the foot is planted. */
+	int32 BoneIndex = INDEX_NONE;
+	/** World transform of the bone, copied on the game thread before the update (the support evaluates in parallel). */
+	FTransform BoneTransform = FTransform(FRotator(0.f), FVector(0.f), FVector(1.f));
+	bool bHasBoneTransform = false;
+	/** Where the foot was planted, until the first bone transform is copied. */
+	FVector PlantLocation = FVector(0.f);
+
+	/** Set the component (and bone) the foot is planted on. */
+	void SetComponent(UPrimitiveComponent* InComponent, FName InBoneName);
+
+	/** Copy the bone transform of a skinned mesh support (game thread). */
+	void UpdateBoneTransform();
+
+	/** Is the transform known yet? (a bone is known from the first copy after the foot is planted) */
+	FORCEINLINE bool HasTransform() const
+	{
+		return BoneIndex == INDEX_NONE || bHasBoneTransform;
+	}
+
+	/** The world transform of the component, or the copied transform of the bone of a skinned mesh. */
+	FTransform GetTransform(const UPrimitiveComponent* SupportComp) const;
+};
+
+/**
+ * Runtime data of all legs, one array per value (SoA), so that per-leg loops only touch the data they use.
+ * Data used every frame is stored inline, data used on plant / events is stored separately.
+ */
+struct SIMPLEPROCEDURALWALK_API FSimpleProceduralWalk_LegsData
+{
+public:
+	// every frame
+	TSimpleProceduralWalk_LegArray<FVector> FootLocations;
+	TSimpleProceduralWalk_LegArray<FVector> FootTargets;
+	TSimpleProceduralWalk_LegArray<FVector> FootUnplantLocations;
+	TSimpleProceduralWalk_LegArray<FQuat> FootTargetRotations;
+	TSimpleProceduralWalk_LegArray<FVector> SupportCompDeltas;
+	TSimpleProceduralWalk_LegArray<int32> GroupIndices;
+	TSimpleProceduralWalk_LegArray<ESimpleProceduralWalk_LegFlags> Flags;
+
+	// set at initialization
+	TSimpleProceduralWalk_LegArray<FVector> TipBoneOriginalRelLocations;
+	TSimpleProceduralWalk_LegArray<float> Lengths;
+
+	// set on trace & plant
+	TArray<FSimpleProceduralWalk_LegHit> LastHits;
+	TArray<FSimpleProceduralWalk_LegSupport> Supports;
+
+	void SetNum(int32 NumLegs);
+
+	FORCEINLINE int32 Num() const
+	{
+		return FootLocations.Num();
+	}
+
+	FORCEINLINE bool HasFlag(int32 LegIndex, ESimpleProceduralWalk_LegFlags Flag) const
+	{
+		return EnumHasAnyFlags(Flags[LegIndex], Flag);
+	}
+
+	FORCEINLINE void SetFlag(int32 LegIndex, ESimpleProceduralWalk_LegFlags Flag, bool bValue)
+	{
+		if (bValue)
+		{
+			Flags[LegIndex] |= Flag;
+		}
+		else
+		{
+			Flags[LegIndex] &= ~Flag;
+		}
+	}
+};
+
+/**
+ * Feet & body of a walker, in actor space, shared with distant walkers of the same skeleton and Walk Profile.
+ */
+struct SIMPLEPROCEDURALWALK_API FSimpleProceduralWalk_PoseSnapshot
+{
+public:
+	TSimpleProceduralWalk_LegArray<FVector> FootRelLocations;
+	TSimpleProceduralWalk_LegArray<FQuat> FootTargetRotations;
+	TSimpleProceduralWalk_LegArray<ESimpleProceduralWalk_LegFlags> Flags;
+	FVector BodyRelLocation = FVector::ZeroVector;
+	FQuat BodyRelRotation = FQuat::Identity;
+	FQuat BodyBoneRotation = FQuat::Identity;
+
+	// solved body & leg bones in component space (sorted), only valid for the same mesh & LOD
+	TArray<FBoneTransform> SolvedBoneTransforms;
+	const UObject* SolvedBonesAsset = nullptr;
+	int32 SolvedBonesLODLevel = INDEX_NONE;
+	int32 SolvedBonesNumBones = 0;
+
+	FORCEINLINE int32 Num() const
+	{
+		return FootRelLocations.Num();
+	}
+};
+
+/** Snapshots are shared between the template and its clones, and never modified once published. */
+typedef TSharedPtr<FSimpleProceduralWalk_PoseSnapshot, ESPMode::ThreadSafe> FSimpleProceduralWalk_PoseSnapshotPtr;
+typedef TSharedPtr<const FSimpleProceduralWalk_PoseSnapshot, ESPMode::ThreadSafe> FSimpleProceduralWalk_PoseSnapshotConstPtr;
+
+/**
+ * Batch conversions of leg locations between world space and a reference space (such as the actor's).
+ * The transform is loaded once in vector registers and applied to all locations.
+ */
+namespace SimpleProceduralWalk_SpaceConversion
+{
+	/** OutLocations[i] = Transform.TransformPosition(InLocations[i]). */
+	SIMPLEPROCEDURALWALK_API void TransformLocations(const FTransform& Transform, const FVector* InLocations, FVector* OutLocations, int32 Num);
+
+	/** OutLocations[i] = Transform.InverseTransformPosition(InLocations[i]). */
+	SIMPLEPROCEDURALWALK_API void InverseTransformLocations(const FTransform& Transform, const FVector* InLocations, FVector* OutLocations, int32 Num);
+}
+
+/**
+ * Least-squares fit of the plane Z = SlopeX * X + SlopeY * Y + C through leg locations, in a single pass of running sums.
+ * The fit is regularized, so that aligned locations (for instance the feet of a biped) give no slope across the line.
+ */
+namespace SimpleProceduralWalk_PlaneFit
+{
+	SIMPLEPROCEDURALWALK_API void FitPlane(const FVector* Locations, int32 Num, float& OutSlopeX, float& OutSlopeY);
+}
+
+/**
+ * Rotation limits of the CCDIK chain links, after the bones removed by LOD.
+ * The first link (parent's parent) is never rotated, so the limit of a removed bone goes to its closest remaining child,
+ * or to its closest remaining ancestor if no child remains.
+ */
+namespace SimpleProceduralWalk_RotationLimits
+{
+	/** Joints from the parent bone to the tip bone, limits in degrees in, in radians out (one per remaining joint, plus the first link). */
+	SIMPLEPROCEDURALWALK_API void Remap(const TArray<float>& RotationLimitPerJoints, TArrayView<const bool> bIsJointRequired, TArray<float>& OutRotationLimits);
+}
+
+/** Tip bones moved to the feet directly in component space (used when the IK solver is disabled, for instance with virtual bones). */
+namespace SimpleProceduralWalk_VirtualBones
+{
+	/**
+	 * Feet locations are in world space, feet rotations in component space, one per tip bone (INDEX_NONE tip bones are skipped).
+	 * All tip bones are blended with Alpha at once, OutTipBoneTransforms is scratch.
+	 */
+	SIMPLEPROCEDURALWALK_API void TransformTipBones(FCSPose<FCompactPose>& Pose
+		, const FTransform& ComponentTransform
+		, TArrayView<const FCompactPoseBoneIndex> TipBoneIndices
+		, const FVector* FootLocations
+		, const FQuat* FootTargetRotations
+		, float Alpha
+		, TArray<FBoneTransform>& OutTipBoneTransforms);
+}
+
+/**
+ * Device scalability of all nodes, from the SPW.* console variables.
+ * Set them per scalability level (sg.ViewDistanceQuality sections of DefaultScalability.ini) or per device profile.
+ */
+struct SIMPLEPROCEDURALWALK_API FSimpleProceduralWalk_Scalability
+{
+public:
+	static float GetMaxIterationsScale();
+	static float GetPrecisionScale();
+	static bool IsBasicSolverForced();
+	static bool IsTraceComplexAllowed();
+	static float GetRadiusCheckScale();
+	static float GetTraceLengthScale();
+};
+
+/**
+ * Measures the CPU time spent by all nodes per frame, and lowers (or raises) a global quality level to hold a target.
+ * Configured with the SPW.Governor.* console variables.
+ */
+struct SIMPLEPROCEDURALWALK_API FSimpleProceduralWalk_Governor
+{
+public:
+	static FSimpleProceduralWalk_Governor& Get();
+
+	/** Close the previous frame (once per frame, whichever node comes first) and update the level. */
+	void BeginFrame(uint64 Frame);
+
+	/** Add the CPU time spent by a node in the current frame. */
+	FORCEINLINE void AddCycles(uint32 Cycles)
+	{
+		FrameCycles += Cycles;
+	}
+
+	/** 0 is full quality, higher levels reduce the quality. */
+	FORCEINLINE int32 GetLevel() const
+	{
+		return Level.Load(EMemoryOrder::Relaxed);
+	}
+
+	// quality knobs of the current level
+	float GetSignificanceScale() const;
+	float GetMaxIterationsScale() const;
+	int32 GetMinTraceInterval() const;
+	bool IsBasicSolverForced() const;
+
+private:
+	TAtomic<uint64> CurrentFrame { 0 };
+	TAtomic<uint64> FrameCycles { 0 };
+	TAtomic<int32> Level { 0 };
+	// only modified by the node closing the frame
+	int32 FramesOverTarget = 0;
+	int32 FramesUnderTarget = 0;
 };
 
 USTRUCT()
@@ -111,6 +349,15 @@ enum class ESimpleProceduralWalk_SolverType : uint8
 	ADVANCED = 1 UMETA(DisplayName = "Advanced"),
 };
 
+UENUM(BlueprintType)
+enum class ESimpleProceduralWalk_QualityTier : uint8
+{
+	FULL = 0 UMETA(DisplayName = "Full"),
+	REDUCED = 1 UMETA(DisplayName = "Reduced"),
+	BODY_ONLY = 2 UMETA(DisplayName = "Body Only"),
+	FROZEN = 3 UMETA(DisplayName = "Frozen"),
+};
+
 UENUM(BlueprintType)
 enum class ESimpleProceduralWalk_StepCurveType : uint8
 {
@@ -118,3 +365,57 @@ enum class ESimpleProceduralWalk_StepCurveType : uint8
 	ORGANIC = 1 UMETA(DisplayName = "Organic"),
 	CUSTOM = 99 UMETA(DisplayName = "Custom"),
 };
+
+/** Number of samples of a baked curve (the curve is sampled over [0, 1]). */
+#define SPW_BAKED_CURVE_SAMPLES 65
+
+/** A curve sampled at initialization, evaluated with linear interpolation between samples. */
+struct SIMPLEPROCEDURALWALK_API FSimpleProceduralWalk_BakedCurve
+{
+public:
+	float Samples[SPW_BAKED_CURVE_SAMPLES] = { 0.f };
+
+	void Bake(const FRichCurve& Curve);
+
+	/** Maximum difference between the baked and the source curve, measured between samples. */
+	float GetMaxDeviation(const FRichCurve& Curve) const;
+
+	FORCEINLINE float Eval(float Time) const
+	{
+		const float SampleTime = FMath::Clamp(Time, 0.f, 1.f) * (SPW_BAKED_CURVE_SAMPLES - 1);
+		const int32 SampleIndex = FMath::Min(FMath::FloorToInt(SampleTime), SPW_BAKED_CURVE_SAMPLES - 2);
+		return FMath::Lerp(Samples[SampleIndex], Samples[SampleIndex + 1], SampleTime - SampleIndex);
+	}
+};
+
+/** The curves that define the foot height and distance evolution during a step. */
+struct SIMPLEPROCEDURALWALK_API FSimpleProceduralWalk_StepCurves
+{
+public:
+	FSimpleProceduralWalk_BakedCurve HeightCurve;
+	FSimpleProceduralWalk_BakedCurve DistanceCurve;
+
+	/** Bake the curves of a UCurveFloat pair (a missing curve evaluates to 0). */
+	void Bake(const class UCurveFloat* InHeightCurve, const class UCurveFloat* InDistanceCurve);
+
+	/** Built-in curves, shared by all nodes (CUSTOM has no built-in curves and returns empty curves). */
+	static const FSimpleProceduralWalk_StepCurves& GetDefault(ESimpleProceduralWalk_StepCurveType StepCurveType);
+
+#if WITH_EDITOR
+	/** Have the source curves changed since they were baked? (curve assets can be edited while walkers are playing) */
+	bool IsStale(const class UCurveFloat* InHeightCurve, const class UCurveFloat* InDistanceCurve) const;
+
+private:
+	uint32 SourceHash = 0;
+#endif
+};
+
+/** Source curves of the built-in step curves (baked once by GetDefault). */
+namespace SimpleProceduralWalk_StepCurves
+{
+	/** Foot height evolution of a built-in step curve type (CUSTOM returns an empty curve). */
+	SIMPLEPROCEDURALWALK_API FRichCurve CreateHeightCurve(ESimpleProceduralWalk_StepCurveType StepCurveType);
+
+	/** Foot distance evolution, common to all built-in step curve types. */
+	SIMPLEPROCEDURALWALK_API FRichCurve CreateDistanceCurve();
+}
@@ -0,0 +1,94 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "Misc/ScopeRWLock.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SPW.h"
+#include "SPWSwarmSubsystem.generated.h"
+
+class USkeleton;
+class USkeletalMeshComponent;
+class USPWWalkProfile;
+
+/** Number of poses kept per template walker, clones copy them with a phase offset within this history. */
+#define SPW_POSE_HISTORY 32
+
+/** Template walkers without clones only register every this many frames, without their pose. */
+#define SPW_POSE_REGISTER_FRAMES 10
+
+/**
+ * Pose sharing between walkers with the same skeleton and Walk Profile.
+ * Template walkers compute and publish their feet, body & solved bones every update while they have clones, clone walkers copy them instead of computing them.
+ * Called from the anim nodes, on any thread: each cluster of walkers has its own lock, only held to swap snapshot pointers.
+ */
+UCLASS()
+class SIMPLEPROCEDURALWALK_API USPWSwarmSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Publish the pose of a template walker, or only register it if InOutSnapshot is null.
+	 * The snapshot is moved to the history, and replaced by the oldest snapshot of the history (to be refilled if no clone holds it anymore).
+	 * Returns true if the template has clones (it should then publish its pose every update).
+	 */
+	bool PublishPose(const USkeleton* Skeleton
+		, const USPWWalkProfile* WalkProfile
+		, const USkeletalMeshComponent* TemplateComponent
+		, const FVector& Location
+		, FSimpleProceduralWalk_PoseSnapshotPtr* InOutSnapshot);
+
+	/**
+	 * Copy the pose of a template walker, published PhaseDelay updates ago.
+	 * The previous template of the clone is kept while valid, otherwise the nearest template within MaxDistance (0 for no limit)
+	 * with less than MaxClones clones is assigned.
+	 * Returns false if no template is available (the walker should compute its own pose, and so become a template),
+	 * or if the assigned template has not published its pose yet.
+	 */
+	bool CopyPose(const USkeleton* Skeleton
+		, const USPWWalkProfile* WalkProfile
+		, const USkeletalMeshComponent* CloneComponent
+		, const FVector& CloneLocation
+		, TWeakObjectPtr<const USkeletalMeshComponent>& InOutTemplateComponent
+		, int32 MaxClones
+		, float MaxDistance
+		, int32 PhaseDelay
+		, FSimpleProceduralWalk_PoseSnapshotConstPtr& OutSnapshot);
+
+private:
+	struct FTemplate
+	{
+		TWeakObjectPtr<const USkeletalMeshComponent> Component;
+		FVector Location = FVector::ZeroVector;
+		// allocated when the template registers, then only swapped
+		FSimpleProceduralWalk_PoseSnapshotPtr History[SPW_POSE_HISTORY];
+		int32 HistoryHead = 0;
+		int32 NumSnapshots = 0;
+		uint64 LastPublishFrame = 0;
+		// clones counted per frame
+		uint64 CloneCountFrame = 0;
+		int32 NumClones = 0;
+		int32 NumClonesPreviousFrame = 0;
+
+		void CountClones(uint64 Frame);
+	};
+
+	/** Walkers with the same skeleton & Walk Profile. */
+	struct FCluster
+	{
+		FCriticalSection CriticalSection;
+		TArray<FTemplate> Templates;
+	};
+
+	typedef TPair<FObjectKey, FObjectKey> FClusterKey;
+
+	// clusters are never removed
+	FRWLock ClustersLock;
+	TMap<FClusterKey, TUniquePtr<FCluster>> Clusters;
+
+	FCluster* FindCluster(const USkeleton* Skeleton, const USPWWalkProfile* WalkProfile, bool bAdd);
+	void PruneTemplates(TArray<FTemplate>& Templates, uint64 Frame);
+};
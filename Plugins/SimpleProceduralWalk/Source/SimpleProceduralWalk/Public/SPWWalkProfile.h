@@ -0,0 +1,140 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Engine/EngineTypes.h"
+#include "SPW.h"
+#include "SPWWalkProfile.generated.h"
+
+class UCurveFloat;
+
+/**
+ * Walk settings shared by all the Simple Procedural Walk nodes that reference it.
+ * Derived data (such as the step curves) is computed once, when the asset is loaded or edited.
+ */
+UCLASS(BlueprintType)
+class SIMPLEPROCEDURALWALK_API USPWWalkProfile : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	USPWWalkProfile();
+
+	// ---------- \/ Walk Cycle ----------
+	/** How far should the foot desired position be from the tip bone before a step is taken. */
+	UPROPERTY(EditAnywhere, Category = "Walk Cycle", meta = (ClampMin = "0.0"))
+		float MinDistanceToUnplant = 0.f;
+
+	/** Do not adjust feet targets if the step is over this percentage. */
+	UPROPERTY(EditAnywhere, Category = "Walk Cycle", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+		float FixFeetTargetsAfterPercent = 0.f;
+
+	/** The foot rotation interpolation speed. */
+	UPROPERTY(EditAnywhere, Category = "Walk Cycle", meta = (ClampMin = "0.0"))
+		float FeetTipBonesRotationInterpSpeed = 0.f;
+
+	// ---------- \/ Step Control ----------
+	/** Defines the curve steps. */
+	UPROPERTY(EditAnywhere, Category = "Step Control")
+		ESimpleProceduralWalk_StepCurveType StepCurveType = ESimpleProceduralWalk_StepCurveType::ROBOT;
+
+	/**
+	 * How much should the step distance be reduced based on slope inclination:
+	 * 0: No reduction.
+	 * 1: With a slope of 90 degrees the step is reduced to 0.
+	 */
+	UPROPERTY(EditAnywhere, Category = "Step Control", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+		float StepSlopeReductionMultiplier = 0.f;
+
+	/** The minimum step duration (steps should never take less than this amount of time). */
+	UPROPERTY(EditAnywhere, Category = "Step Control", meta = (ClampMin = "0.0"))
+		float MinStepDuration = 0.f;
+
+	/** The curve that defines the foot height evolution during a step. */
+	UPROPERTY(EditAnywhere, Category = "Step Control", meta = (EditCondition = "StepCurveType == ESimpleProceduralWalk_StepCurveType::CUSTOM"))
+		UCurveFloat* CustomStepHeightCurve = nullptr;
+
+	/** The curve that defines the foot distance evolution during a step. */
+	UPROPERTY(EditAnywhere, Category = "Step Control", meta = (EditCondition = "StepCurveType == ESimpleProceduralWalk_StepCurveType::CUSTOM"))
+		UCurveFloat* CustomStepDistanceCurve = nullptr;
+
+	// ---------- \/ Body Rotation ----------
+	/** How much should the acceleration influence the body rotation. */
+	UPROPERTY(EditAnywhere, Category = "Body Rotation", meta = (ClampMin = "0.0"))
+		float BodyAccelerationRotationMultiplier = 0.f;
+
+	/** How much should the feet locations influence the body rotation. */
+	UPROPERTY(EditAnywhere, Category = "Body Rotation", meta = (ClampMin = "0.0"))
+		float BodyFeetLocationsRotationMultiplier = 0.f;
+
+	/** Maximum body rotation, per axis: Roll (X), Pitch (Y), and Yaw (Z, ignored). */
+	UPROPERTY(EditAnywhere, Category = "Body Rotation", meta = (ClampMin = "0.0"))
+		FRotator MaxBodyRotation = FRotator(0.f);
+
+	// ---------- \/ Solver ----------
+	/** The ADVANCED solver type is more accurate to some world scenarios, but it's more expensive. */
+	UPROPERTY(EditAnywhere, Category = "Solver")
+		ESimpleProceduralWalk_SolverType SolverType;
+
+	/** How quickly should feet interpolate while the pawn is falling. */
+	UPROPERTY(EditAnywhere, Category = "Solver", meta = (ClampMin = "0.0"))
+		float FeetInAirInterSpeed = 0.f;
+
+	/** Specifies the radius within which to check for existing places where to plant feet. */
+	UPROPERTY(EditAnywhere, Category = "Solver", meta = (ClampMin = "1.0", ClampMax = "3.0", EditCondition = "SolverType == ESimpleProceduralWalk_SolverType::ADVANCED"))
+		float RadiusCheckMultiplier = 0.f;
+
+	/** Specifies when the basic vertical location where to plant the foot should be abandoned and a location within a radius should be searched for instead. */
+	UPROPERTY(EditAnywhere, Category = "Solver", meta = (ClampMin = "1.0", ClampMax = "3.0", EditCondition = "SolverType == ESimpleProceduralWalk_SolverType::ADVANCED"))
+		float DistanceCheckMultiplier = 0.f;
+
+	// ---------- \/ IK Solver ----------
+	/** Tolerance for final tip bone location delta. */
+	UPROPERTY(EditAnywhere, Category = "IK Solver", meta = (ClampMin = "0.0"))
+		float Precision = 0.f;
+
+	/** Maximum number of iterations allowed, to control performance. */
+	UPROPERTY(EditAnywhere, Category = "IK Solver", meta = (ClampMin = "0"))
+		int32 MaxIterations = 0;
+
+	// ---------- \/ Trace ----------
+	/** The trace channel. */
+	UPROPERTY(EditAnywhere, Category = "Trace")
+		TEnumAsByte<ETraceTypeQuery> TraceChannel;
+
+	/** The length of the downwards trace. */
+	UPROPERTY(EditAnywhere, Category = "Trace", meta = (ClampMin = "0.0"))
+		float TraceLength = 0.f;
+
+	/** Should the trace be complex? */
+	UPROPERTY(EditAnywhere, Category = "Trace")
+		bool bTraceComplex = false;
+
+	/** Trace offset (from the foot Parent Bone). */
+	UPROPERTY(EditAnywhere, Category = "Trace")
+		float TraceZOffset = 0.f;
+
+public:
+	// UObject interface
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	/** The baked step curves of this profile (the built-in ones, or the custom ones). */
+	const FSimpleProceduralWalk_StepCurves& GetStepCurves() const;
+
+#if WITH_EDITOR
+	/** Have the custom step curve assets been edited since they were baked? */
+	bool AreStepCurvesStale() const;
+
+	/** Rebake the custom step curves if their assets have been edited (game thread). */
+	void RebakeStaleStepCurves();
+#endif
+
+private:
+	FSimpleProceduralWalk_StepCurves CustomStepCurves;
+	void BakeDerivedData();
+};
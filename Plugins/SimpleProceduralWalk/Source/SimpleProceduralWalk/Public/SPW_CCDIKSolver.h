@@ -5,8 +5,12 @@
 #include "CoreMinimal.h"
 #include "UObject/ObjectMacros.h"
 #include "BoneIndices.h"
+#include "BonePose.h"
 #include "SPW_CCDIKSolver.generated.h"
 
+/** Number of legs solved at the same time by the vectorized CCDIK (one leg per SIMD lane). */
+#define SPW_CCDIK_LANES 4
+
 /** Transient structure for CCDIK node evaluation */
 USTRUCT()
 struct FSPW_CCDIKChainLink
@@ -25,7 +29,7 @@ public:
 
 	/** Child bones which are overlapping this bone.
 	 * They have a zero length distance, so they will inherit this bone's transformation. */
-	TArray<int32> ChildZeroLengthTransformIndices;
+	TArray<int32, TInlineAllocator<2>> ChildZeroLengthTransformIndices;
 
 	float CurrentAngleDelta = 0.f;
 
@@ -43,3 +47,85 @@ public:
 	{
 	}
 };
+
+/** Transient per-leg chain, gathered before solving so that legs can be solved in batches. */
+struct FSPW_CCDIKLegChain
+{
+	/** Indices of all bones between root and tip. */
+	TArray<FCompactPoseBoneIndex> BoneIndices;
+
+	/** Transforms of all bones between root and tip, in component space. */
+	TArray<FBoneTransform> Transforms;
+
+	/** Chain links (non zero length bones). */
+	TArray<FSPW_CCDIKChainLink> Chain;
+
+	/** Effector location in component space. */
+	FVector EffectorLocation = FVector(0.f);
+
+	/** Has the chain been gathered during the current evaluation? */
+	bool bIsGathered = false;
+
+	/** Has the solver moved any bone of the chain? */
+	bool bBoneLocationUpdated = false;
+
+	/** Tolerance for final tip bone location delta used for this leg. */
+	float Precision = 0.f;
+
+	/** Maximum number of iterations allowed for this leg. */
+	int32 MaxIterations = 0;
+
+	/** Number of iterations performed by the last solve. */
+	int32 Iterations = 0;
+
+	/** Distance between the tip and the effector after the last solve. */
+	float ResidualError = 0.f;
+
+	/** Is the cached solution reused during the current evaluation? */
+	bool bIsCacheHit = false;
+
+	/** Is the cached solution valid? */
+	bool bIsCacheValid = false;
+
+	/** Solver inputs of the cached solution. */
+	TArray<FTransform> CachedInputTransforms;
+	FVector CachedEffectorLocation = FVector(0.f);
+	FQuat CachedFootTargetRotation = FQuat::Identity;
+	FVector CachedBodyRelLocation = FVector(0.f);
+	FQuat CachedBodyRelRotation = FQuat::Identity;
+
+	/** Solver settings & residual error of the cached solution. */
+	float CachedPrecision = 0.f;
+	int32 CachedMaxIterations = 0;
+	float CachedResidualError = 0.f;
+
+	/** Cached solution, in component space. */
+	TArray<FBoneTransform> CachedOutputTransforms;
+};
+
+/**
+ * The same link index of up to SPW_CCDIK_LANES legs, in SoA layout.
+ * Chains are aligned on their tip, so that shorter chains are padded (and masked) at their root.
+ */
+struct FSPW_CCDIKLinkLanes
+{
+	/** Component space location. */
+	VectorRegister LocationX;
+	VectorRegister LocationY;
+	VectorRegister LocationZ;
+
+	/** Component space rotation. */
+	VectorRegister RotationX;
+	VectorRegister RotationY;
+	VectorRegister RotationZ;
+	VectorRegister RotationW;
+
+	/** Accumulated rotation, used for rotation limits (radians). */
+	VectorRegister AngleDelta;
+
+	/** Rotation limit (radians). */
+	VectorRegister RotationLimit;
+
+	/** Lanes in which this link can be rotated by the solver. */
+	VectorRegister SolveMask;
+};
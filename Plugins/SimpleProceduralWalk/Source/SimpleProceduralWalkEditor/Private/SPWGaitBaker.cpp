@@ -0,0 +1,413 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#include "SPWGaitBaker.h"
+#include "SimpleProceduralWalkEditor.h"
+#include "AnimNode_SPW.h"
+#include "AnimationRecorder.h"
+#include "Animation/AnimationRecordingSettings.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/BlendSpace.h"
+#include "AssetRegistryModule.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/FloatingPawnMovement.h"
+#include "GameFramework/Pawn.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+
+
+// the walk node of the anim instance (anim graph nodes are properties of the anim blueprint class)
+static const FAnimNode_SPW* FindWalkNode(const USkeletalMeshComponent* SkeletalMeshComponent)
+{
+	const UAnimInstance* AnimInstance = SkeletalMeshComponent != nullptr ? SkeletalMeshComponent->GetAnimInstance() : nullptr;
+	if (AnimInstance == nullptr)
+	{
+		return nullptr;
+	}
+
+	for (TFieldIterator<FStructProperty> It(AnimInstance->GetClass()); It; ++It)
+	{
+		if (It->Struct->IsChildOf(FAnimNode_SPW::StaticStruct()))
+		{
+			return It->ContainerPtrToValuePtr<FAnimNode_SPW>(AnimInstance);
+		}
+	}
+	return nullptr;
+}
+
+// -180 & 180 are the same direction, recorded once and added on both ends of the blend space
+static bool GetMirroredDirection(float Direction, const TArray<float>& Directions, float& OutMirroredDirection)
+{
+	if (FMath::Abs(Direction) != 180.f)
+	{
+		return false;
+	}
+
+	OutMirroredDirection = -Direction;
+	return !Directions.Contains(OutMirroredDirection);
+}
+
+FSPWGaitBakeSettings::FSPWGaitBakeSettings()
+{
+	Speeds = { 0.f, 150.f, 300.f };
+	Directions = { -180.f, -90.f, 0.f, 90.f };
+}
+
+USPWGaitBaker* USPWGaitBaker::BakeGaits(APawn* Walker, const FSPWGaitBakeSettings& Settings)
+{
+	USPWGaitBaker* Baker = NewObject<USPWGaitBaker>();
+	if (!Baker->Start(Walker, Settings))
+	{
+		return nullptr;
+	}
+	return Baker;
+}
+
+TStatId USPWGaitBaker::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USPWGaitBaker, STATGROUP_Tickables);
+}
+
+bool USPWGaitBaker::Start(APawn* InWalker, const FSPWGaitBakeSettings& InSettings)
+{
+	if (!IsValid(InWalker) || InWalker->FindComponentByClass<USkeletalMeshComponent>() == nullptr || InWalker->GetMovementComponent() == nullptr)
+	{
+		UE_LOG(LogSimpleProceduralWalkEditor, Error, TEXT("Gait bake needs a walker with a skeletal mesh and a movement component."));
+		return false;
+	}
+
+	// walk cycles are measured on the gait phase
+	if (FindWalkNode(InWalker->FindComponentByClass<USkeletalMeshComponent>()) == nullptr)
+	{
+		UE_LOG(LogSimpleProceduralWalkEditor, Error, TEXT("Gait bake needs a walker with a Simple Procedural Walk node in its anim blueprint."));
+		return false;
+	}
+
+	Walker = InWalker;
+	Settings = InSettings;
+
+	// samples (idle is recorded once)
+	Samples.Reset();
+	for (float Speed : Settings.Speeds)
+	{
+		if (Speed <= 0.f)
+		{
+			Samples.Add({ 0.f, 0.f });
+			continue;
+		}
+		for (float Direction : Settings.Directions)
+		{
+			Samples.Add({ Speed, Direction });
+		}
+	}
+
+	if (Samples.Num() == 0)
+	{
+		UE_LOG(LogSimpleProceduralWalkEditor, Error, TEXT("Gait bake has no speeds or directions to record."));
+		return false;
+	}
+
+	// walker moves in the sample direction, without turning
+	StartLocation = Walker->GetActorLocation();
+	StartRotation = Walker->GetActorRotation();
+	if (UCharacterMovementComponent* CharacterMovement = Cast<UCharacterMovementComponent>(Walker->GetMovementComponent()))
+	{
+		OriginalMaxSpeed = CharacterMovement->MaxWalkSpeed;
+		bOriginalOrientRotationToMovement = CharacterMovement->bOrientRotationToMovement;
+		CharacterMovement->bOrientRotationToMovement = false;
+	}
+	else if (UFloatingPawnMovement* FloatingMovement = Cast<UFloatingPawnMovement>(Walker->GetMovementComponent()))
+	{
+		OriginalMaxSpeed = FloatingMovement->MaxSpeed;
+	}
+
+	// kept alive until done
+	AddToRoot();
+	Sequences.Reset();
+	SampleIndex = 0;
+	bIsBaking = true;
+	StartSample();
+
+	return true;
+}
+
+void USPWGaitBaker::Tick(float DeltaTime)
+{
+	if (!IsValid(Walker))
+	{
+		UE_LOG(LogSimpleProceduralWalkEditor, Error, TEXT("Gait bake stopped, the walker was destroyed."));
+		FAnimationRecorderManager::Get().StopRecordingDeadAnimations(false);
+		bIsBaking = false;
+		RemoveFromRoot();
+		return;
+	}
+
+	const FSample& Sample = Samples[SampleIndex];
+
+	// move
+	if (Sample.Speed > 0.f)
+	{
+		const FVector MoveDirection = Walker->GetActorForwardVector().RotateAngleAxis(Sample.Direction, Walker->GetActorUpVector());
+		Walker->AddMovementInput(MoveDirection, 1.f, true);
+	}
+
+	StateTime += DeltaTime;
+
+	switch (State)
+	{
+	case EState::WARM_UP:
+		if (StateTime >= Settings.WarmUpTime)
+		{
+			if (Sample.Speed > 0.f)
+			{
+				/* -> walk cycle established, wait for its start */
+				IsGaitCycleStart();
+				State = EState::WAIT_CYCLE_START;
+				StateTime = 0.f;
+			}
+			else
+			{
+				/* -> idle, no walk cycle */
+				StartRecording(Settings.IdleDuration);
+			}
+		}
+		break;
+
+	case EState::WAIT_CYCLE_START:
+		if (IsGaitCycleStart())
+		{
+			/* -> first group unplants, record whole cycles */
+			StartRecording(0.f);
+		}
+		else if (StateTime >= Settings.MaxCycleTime)
+		{
+			UE_LOG(LogSimpleProceduralWalkEditor, Warning, TEXT("No walk cycle detected for gait sample %d, recorded for Max Cycle Time instead."), SampleIndex + 1);
+			StartRecording(Settings.MaxCycleTime);
+		}
+		break;
+
+	case EState::RECORDING:
+	{
+		bool bIsDone = false;
+
+		if (RecordDuration > 0.f)
+		{
+			// fixed length
+			bIsDone = StateTime >= RecordDuration;
+		}
+		else if (IsGaitCycleStart())
+		{
+			/* -> cycle done */
+			NumRecordedCycles++;
+			UE_LOG(LogSimpleProceduralWalkEditor, Log, TEXT("Walk cycle %d of gait sample %d lasted %f seconds.")
+				, NumRecordedCycles
+				, SampleIndex + 1
+				, StateTime - CycleStartTime);
+			CycleStartTime = StateTime;
+			bIsDone = NumRecordedCycles >= Settings.NumCycles;
+		}
+		else if (StateTime - CycleStartTime >= Settings.MaxCycleTime)
+		{
+			UE_LOG(LogSimpleProceduralWalkEditor, Warning, TEXT("Walk cycle of gait sample %d did not end within Max Cycle Time, the sequence will not loop."), SampleIndex + 1);
+			bIsDone = true;
+		}
+
+		if (bIsDone)
+		{
+			/* -> next sample */
+			StopSample();
+			SampleIndex++;
+			if (SampleIndex < Samples.Num())
+			{
+				StartSample();
+			}
+			else
+			{
+				Finish();
+			}
+		}
+		break;
+	}
+	}
+}
+
+bool USPWGaitBaker::IsGaitCycleStart()
+{
+	const FAnimNode_SPW* WalkNode = FindWalkNode(Walker->FindComponentByClass<USkeletalMeshComponent>());
+	if (WalkNode == nullptr)
+	{
+		return false;
+	}
+
+	// phase wraps around when the first group unplants
+	const float GaitPhase = WalkNode->GetGaitPhase();
+	const bool bIsCycleStart = GaitPhase < PreviousGaitPhase - .5f;
+	PreviousGaitPhase = GaitPhase;
+
+	return bIsCycleStart;
+}
+
+void USPWGaitBaker::StartSample()
+{
+	const FSample& Sample = Samples[SampleIndex];
+
+	UE_LOG(LogSimpleProceduralWalkEditor, Log, TEXT("Baking gait sample %d / %d (speed: %f, direction: %f).")
+		, SampleIndex + 1
+		, Samples.Num()
+		, Sample.Speed
+		, Sample.Direction);
+
+	// back to the start, so that all samples are recorded on the same ground
+	Walker->SetActorLocationAndRotation(StartLocation, StartRotation, false, nullptr, ETeleportType::TeleportPhysics);
+	Walker->GetMovementComponent()->StopMovementImmediately();
+	SetMaxSpeed(Sample.Speed);
+
+	State = EState::WARM_UP;
+	StateTime = 0.f;
+}
+
+void USPWGaitBaker::StartRecording(float Duration)
+{
+	const FSample& Sample = Samples[SampleIndex];
+
+	FAnimationRecordingSettings RecordingSettings;
+	RecordingSettings.bRecordInWorldSpace = false;
+	RecordingSettings.bRemoveRootAnimation = true;
+	RecordingSettings.SampleRate = Settings.SampleRate;
+	RecordingSettings.Length = 0.f;
+
+	const FString SampleAssetName = FString::Printf(TEXT("%s_Speed%d_Dir%s%d")
+		, *Settings.AssetName
+		, FMath::RoundToInt(Sample.Speed)
+		, Sample.Direction < 0.f ? TEXT("M") : TEXT("")
+		, FMath::Abs(FMath::RoundToInt(Sample.Direction)));
+
+	FAnimationRecorderManager::Get().RecordAnimation(Walker->FindComponentByClass<USkeletalMeshComponent>()
+		, Settings.AssetPath
+		, SampleAssetName
+		, RecordingSettings);
+
+	// 0: until the recorded walk cycles are done
+	RecordDuration = Duration;
+	NumRecordedCycles = 0;
+	CycleStartTime = 0.f;
+
+	State = EState::RECORDING;
+	StateTime = 0.f;
+}
+
+void USPWGaitBaker::StopSample()
+{
+	USkeletalMeshComponent* SkeletalMeshComponent = Walker->FindComponentByClass<USkeletalMeshComponent>();
+
+	// kept even if null, one sequence per sample
+	Sequences.Add(FAnimationRecorderManager::Get().GetCurrentlyRecordingSequence(SkeletalMeshComponent));
+	FAnimationRecorderManager::Get().StopRecordingAnimation(SkeletalMeshComponent, false);
+}
+
+void USPWGaitBaker::Finish()
+{
+	// restore the walker
+	SetMaxSpeed(OriginalMaxSpeed);
+	if (UCharacterMovementComponent* CharacterMovement = Cast<UCharacterMovementComponent>(Walker->GetMovementComponent()))
+	{
+		CharacterMovement->bOrientRotationToMovement = bOriginalOrientRotationToMovement;
+	}
+	Walker->GetMovementComponent()->StopMovementImmediately();
+
+	CreateBlendSpace();
+
+	UE_LOG(LogSimpleProceduralWalkEditor, Log, TEXT("Gait bake done."));
+	bIsBaking = false;
+	RemoveFromRoot();
+}
+
+void USPWGaitBaker::CreateBlendSpace()
+{
+	const UAnimSequence* const* FirstSequence = Sequences.FindByPredicate([](const UAnimSequence* Sequence) { return Sequence != nullptr; });
+	if (FirstSequence == nullptr)
+	{
+		UE_LOG(LogSimpleProceduralWalkEditor, Error, TEXT("Gait bake recorded no sequences, no blend space is created."));
+		return;
+	}
+
+	const FString PackageName = Settings.AssetPath / (Settings.AssetName + TEXT("_BlendSpace"));
+	UPackage* Package = CreatePackage(*PackageName);
+	BlendSpace = NewObject<UBlendSpace>(Package, *FPackageName::GetShortName(PackageName), RF_Public | RF_Standalone);
+	BlendSpace->SetSkeleton((*FirstSequence)->GetSkeleton());
+
+	// axes: Direction (X) & Speed (Y), as in the usual locomotion blend spaces
+	float MaxSpeed = 0.f;
+	for (float Speed : Settings.Speeds)
+	{
+		MaxSpeed = FMath::Max(MaxSpeed, Speed);
+	}
+
+	FStructProperty* BlendParametersProperty = FindFProperty<FStructProperty>(UBlendSpaceBase::StaticClass(), TEXT("BlendParameters"));
+	FBlendParameter* DirectionParameter = BlendParametersProperty->ContainerPtrToValuePtr<FBlendParameter>(BlendSpace, 0);
+	DirectionParameter->DisplayName = TEXT("Direction");
+	DirectionParameter->Min = -180.f;
+	DirectionParameter->Max = 180.f;
+	int32 NumDirections = Settings.Directions.Num();
+	for (float Direction : Settings.Directions)
+	{
+		float MirroredDirection;
+		NumDirections += GetMirroredDirection(Direction, Settings.Directions, MirroredDirection) ? 1 : 0;
+	}
+	DirectionParameter->GridNum = FMath::Max(NumDirections - 1, 1);
+
+	FBlendParameter* SpeedParameter = BlendParametersProperty->ContainerPtrToValuePtr<FBlendParameter>(BlendSpace, 1);
+	SpeedParameter->DisplayName = TEXT("Speed");
+	SpeedParameter->Min = 0.f;
+	SpeedParameter->Max = FMath::Max(MaxSpeed, 1.f);
+	SpeedParameter->GridNum = FMath::Max(Settings.Speeds.Num() - 1, 1);
+
+	// samples (idle on all directions)
+	for (int32 Index = 0; Index < Samples.Num(); Index++)
+	{
+		if (Sequences[Index] == nullptr)
+		{
+			continue;
+		}
+
+		float MirroredDirection;
+		if (Samples[Index].Speed > 0.f)
+		{
+			BlendSpace->AddSample(Sequences[Index], FVector(Samples[Index].Direction, Samples[Index].Speed, 0.f));
+			if (GetMirroredDirection(Samples[Index].Direction, Settings.Directions, MirroredDirection))
+			{
+				BlendSpace->AddSample(Sequences[Index], FVector(MirroredDirection, Samples[Index].Speed, 0.f));
+			}
+		}
+		else
+		{
+			for (float Direction : Settings.Directions)
+			{
+				BlendSpace->AddSample(Sequences[Index], FVector(Direction, 0.f, 0.f));
+				if (GetMirroredDirection(Direction, Settings.Directions, MirroredDirection))
+				{
+					BlendSpace->AddSample(Sequences[Index], FVector(MirroredDirection, 0.f, 0.f));
+				}
+			}
+		}
+	}
+
+	BlendSpace->ValidateSampleData();
+	BlendSpace->PostEditChange();
+
+	FAssetRegistryModule::AssetCreated(BlendSpace);
+	BlendSpace->MarkPackageDirty();
+}
+
+void USPWGaitBaker::SetMaxSpeed(float MaxSpeed)
+{
+	if (UCharacterMovementComponent* CharacterMovement = Cast<UCharacterMovementComponent>(Walker->GetMovementComponent()))
+	{
+		CharacterMovement->MaxWalkSpeed = MaxSpeed;
+	}
+	else if (UFloatingPawnMovement* FloatingMovement = Cast<UFloatingPawnMovement>(Walker->GetMovementComponent()))
+	{
+		FloatingMovement->MaxSpeed = MaxSpeed;
+	}
+}
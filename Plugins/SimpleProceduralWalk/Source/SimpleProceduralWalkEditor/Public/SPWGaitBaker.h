@@ -0,0 +1,139 @@
+// Copyright Roberto Ostinelli, 2021. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "SPWGaitBaker.generated.h"
+
+class APawn;
+class UAnimSequence;
+class UBlendSpace;
+
+USTRUCT(BlueprintType)
+struct SIMPLEPROCEDURALWALKEDITOR_API FSPWGaitBakeSettings
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	FSPWGaitBakeSettings();
+
+	/** The speeds to record (one sequence per speed & direction, 0 records the idle pose). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake")
+		TArray<float> Speeds;
+
+	/**
+	 * The movement directions to record, in degrees from the pawn forward (as computed by Calculate Direction).
+	 * -180 and 180 are the same direction: only one of them needs to be recorded, it is added on both ends of the blend space.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake")
+		TArray<float> Directions;
+
+	/** How long should the walker move before recording, so that the walk cycle is established. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "0.0"))
+		float WarmUpTime = 1.5f;
+
+	/**
+	 * The number of walk cycles recorded in each sequence, starting when the first group unplants (gait phase 0).
+	 * Set the same value in the Baked Gait Cycles of the node.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "1"))
+		int32 NumCycles = 1;
+
+	/** The length of the idle sequence (speed 0, no walk cycle). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "0.1"))
+		float IdleDuration = 1.f;
+
+	/** The longest a walk cycle can last: without a cycle detected in this time, the sample is recorded for this time instead. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "0.1"))
+		float MaxCycleTime = 5.f;
+
+	/** The sample rate of the recorded sequences. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "1"))
+		int32 SampleRate = 30;
+
+	/** The content folder of the baked assets. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake")
+		FString AssetPath = TEXT("/Game/SPW_Baked");
+
+	/** The prefix of the baked assets names. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake")
+		FString AssetName = TEXT("SPW_Gait");
+};
+
+/**
+ * Bakes the procedural gait of a walker into looping sequences and a Direction / Speed blend space, to be played at far LODs.
+ * Runs in Play In Editor, on a walker standing on flat ground and possessed by a controller (for instance an AI Controller):
+ * the walker is moved over all speed & direction samples, and whole walk cycles of its pose (from gait phase 0) are recorded
+ * with the animation recorder. The node plays the blend space in the Frozen tier, synced on its gait phase (Baked Gait Blend Space).
+ */
+UCLASS(BlueprintType)
+class SIMPLEPROCEDURALWALKEDITOR_API USPWGaitBaker : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Start baking the gait of the walker, the blend space is created once all samples are recorded. */
+	UFUNCTION(BlueprintCallable, Category = "Simple Procedural Walk|Bake")
+		static USPWGaitBaker* BakeGaits(APawn* Walker, const FSPWGaitBakeSettings& Settings);
+
+	/** Is the bake still running? */
+	UFUNCTION(BlueprintPure, Category = "Simple Procedural Walk|Bake")
+		bool IsBaking() const { return bIsBaking; }
+
+	/** The baked blend space (once the bake is done). */
+	UFUNCTION(BlueprintPure, Category = "Simple Procedural Walk|Bake")
+		UBlendSpace* GetBlendSpace() const { return BlendSpace; }
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return bIsBaking; }
+	virtual TStatId GetStatId() const override;
+
+private:
+	struct FSample
+	{
+		float Speed = 0.f;
+		float Direction = 0.f;
+	};
+
+	enum class EState : uint8
+	{
+		WARM_UP,
+		WAIT_CYCLE_START,
+		RECORDING,
+	};
+
+	UPROPERTY()
+		APawn* Walker = nullptr;
+
+	UPROPERTY()
+		TArray<UAnimSequence*> Sequences;
+
+	UPROPERTY()
+		UBlendSpace* BlendSpace = nullptr;
+
+	FSPWGaitBakeSettings Settings;
+	TArray<FSample> Samples;
+	int32 SampleIndex = 0;
+	EState State = EState::WARM_UP;
+	float StateTime = 0.f;
+	float PreviousGaitPhase = 0.f;
+	int32 NumRecordedCycles = 0;
+	float CycleStartTime = 0.f;
+	float RecordDuration = 0.f;
+	FVector StartLocation = FVector(0.f);
+	FRotator StartRotation = FRotator(0.f);
+	float OriginalMaxSpeed = 0.f;
+	bool bOriginalOrientRotationToMovement = false;
+	bool bIsBaking = false;
+
+	bool Start(APawn* InWalker, const FSPWGaitBakeSettings& InSettings);
+	void StartSample();
+	void StartRecording(float Duration);
+	void StopSample();
+	bool IsGaitCycleStart();
+	void Finish();
+	void CreateBlendSpace();
+	void SetMaxSpeed(float MaxSpeed);
+};
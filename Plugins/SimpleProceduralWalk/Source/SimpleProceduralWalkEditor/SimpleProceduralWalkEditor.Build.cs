@@ -40,6 +40,7 @@ public class SimpleProceduralWalkEditor : ModuleRules
 				"AnimGraph",
 				"BlueprintGraph",
 				"AnimGraphRuntime",
+				"AssetRegistry",
 			}
 			);
 		